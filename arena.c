@@ -0,0 +1,132 @@
+#include "defs.h"
+
+ArenaChunk* newChunk(Arena* arena, size_t bytes);
+
+//The arena of the games played on each thread, so workers never share one
+static __thread Arena threadArena;
+//Arena games set up on this thread allocate from instead, NULL for threadArena
+static __thread Arena* usedArena;
+
+/*
+    Function: gameArena()
+    Purpose:  Gives the arena of the calling thread. Games played one after another on a thread reuse its blocks, so once
+              the first game has warmed it up a game makes no calls into the heap.
+    Return: Arena* - returns the calling thread's arena, or the one arenaUse chose.
+*/
+Arena* gameArena(){
+    return (usedArena != NULL) ? usedArena : &threadArena;
+}
+
+/*
+    Function: arenaUse(Arena* arena)
+    Purpose:  Chooses the arena the games set up on the calling thread allocate from. Games that are played at the same time on
+              one thread, and so end in any order, each need their own arena.
+    Params:
+        Input: Arena* arena - points to the arena, or NULL to go back to the thread's own.
+    Return: void
+*/
+void arenaUse(Arena* arena){
+    usedArena = arena;
+}
+
+/*
+    Function: arenaAlloc(Arena* arena, size_t bytes)
+    Purpose:  Hands out memory from the arena, aligned to ARENA_ALIGN. Moves on to the next block when the current one is
+              full, and only asks the heap for a new block when no block after the current one is large enough.
+    Params:
+        Input/Output: Arena* arena - points to the arena.
+        Input: size_t bytes - stores the size of the allocation.
+    Return: void* - returns the memory, which is not cleared.
+*/
+void* arenaAlloc(Arena* arena, size_t bytes){
+    bytes = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if(arena->current == NULL || arena->used + bytes > arena->current->size){
+        ArenaChunk* chunk = (arena->current == NULL) ? arena->head : arena->current->next;
+        //Blocks too small for this request are skipped, they are used again after the next release
+        while(chunk != NULL && chunk->size < bytes){
+            chunk = chunk->next;
+        }
+        if(chunk == NULL){
+            chunk = newChunk(arena, bytes);
+            arena->heapCalls++;
+            //New blocks go after the current one, so a release to an earlier mark still reaches them
+            if(arena->current == NULL){
+                chunk->next = arena->head;
+                arena->head = chunk;
+            }
+            else{
+                chunk->next = arena->current->next;
+                arena->current->next = chunk;
+            }
+        }
+        arena->current = chunk;
+        arena->used = 0;
+    }
+    void* memory = (unsigned char*) arena->current + ARENA_ALIGN + arena->used;
+    arena->used += bytes;
+    return memory;
+}
+
+/*
+    Function: newChunk(Arena* arena, size_t bytes)
+    Purpose:  Takes a block for an arena from the heap, at least the arena's chunkBytes large.
+    Params:
+        Input: Arena* arena - points to the arena the block is for.
+        Input: size_t bytes - stores the size of the allocation the block is needed for.
+    Return: ArenaChunk* - returns the block, which is in no list yet.
+*/
+ArenaChunk* newChunk(Arena* arena, size_t bytes){
+    size_t smallest = (arena->chunkBytes > 0) ? arena->chunkBytes : ARENA_CHUNK_BYTES;
+    size_t size = (bytes > smallest) ? bytes : smallest;
+    ArenaChunk* chunk = (ArenaChunk*) aligned_alloc(ARENA_ALIGN, ARENA_ALIGN + size);
+    chunk->next = NULL;
+    chunk->size = size;
+    return chunk;
+}
+
+/*
+    Function: arenaMark(Arena* arena)
+    Purpose:  Records where the arena stands, so everything allocated afterwards can be released at once.
+    Params:
+        Input: Arena* arena - points to the arena.
+    Return: ArenaMark - returns the position of the arena.
+*/
+ArenaMark arenaMark(Arena* arena){
+    ArenaMark mark;
+    mark.chunk = arena->current;
+    mark.used = arena->used;
+    return mark;
+}
+
+/*
+    Function: arenaRelease(Arena* arena, ArenaMark mark)
+    Purpose:  Releases everything allocated since a mark in constant time, however much it was. The blocks stay with the
+              arena. Marks are released in the reverse order they were taken, as games nest on a thread.
+    Params:
+        Input/Output: Arena* arena - points to the arena.
+        Input: ArenaMark mark - stores the position to move the arena back to.
+    Return: void
+*/
+void arenaRelease(Arena* arena, ArenaMark mark){
+    arena->current = mark.chunk;
+    arena->used = mark.used;
+}
+
+/*
+    Function: arenaFree(Arena* arena)
+    Purpose:  Gives every block of an arena back to the heap, once its thread plays no more games.
+    Params:
+        Input/Output: Arena* arena - points to the arena, which is left empty and can be used again.
+    Return: void
+*/
+void arenaFree(Arena* arena){
+    ArenaChunk* chunk = arena->head;
+    while(chunk != NULL){
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+}
@@ -0,0 +1,178 @@
+#include "defs.h"
+
+/*
+    Function: runBatch(Options* options)
+    Purpose:  Runs many headless games in this process on the run farm and prints the aggregate outcomes.
+    Params:
+        Input: Options* options - stores the number of runs, the engine, the number of workers and the seed.
+    Return: void
+*/
+void runBatch(Options* options){
+    //Nobody is reading the per-action log in a batch, and printing it would dominate the run time
+    l_setEnabled(C_FALSE);
+
+    BatchStats stats;
+    struct timespec batchStart, batchEnd;
+    clock_gettime(CLOCK_MONOTONIC, &batchStart);
+    runFarm(options, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &batchEnd);
+    double seconds = (batchEnd.tv_sec - batchStart.tv_sec) + (batchEnd.tv_nsec - batchStart.tv_nsec) / 1e9;
+    printBatchStats(&stats, options, seconds);
+}
+
+/*
+    Function: runGame(Options* options, int runId, char hunterNames[][MAX_STR], GameResult* result)
+    Purpose:  Builds a fresh game, plays it to the end on the requested engine and frees it again.
+    Params:
+        Input: Options* options - stores the engine the game runs on and the number of hunters and ghosts.
+        Input: int runId - stores the id of the run within the batch.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters.
+        Output: GameResult* result - points to the outcome of the game.
+    Return: void
+*/
+void runGame(Options* options, int runId, char hunterNames[][MAX_STR], GameResult* result){
+    HouseType house;
+    initGame(&house, hunterNames, options->hunters, options->ghosts, runId);
+    long length = runEngine(&house, options->engine);
+    traceEndGame(&house);
+    evaluateGame(&house, result);
+    result->length = length;
+    freeProgram(&house);
+}
+
+/*
+    Function: recordResult(BatchStats* stats, GameResult* result)
+    Purpose:  Adds the outcome of one game to the aggregate outcomes.
+    Params:
+        Input/Output: BatchStats* stats - points to the aggregate outcomes.
+        Input: GameResult* result - points to the outcome of the game being added.
+    Return: void
+*/
+void recordResult(BatchStats* stats, GameResult* result){
+    //Same rules printEndIntro uses to decide who won
+    if(result->fearCount >= result->numHunters){
+        stats->fearWins++;
+    }
+    else if(result->boredCount >= result->numHunters){
+        stats->boredomWins++;
+    }
+    else if(result->fearCount + result->boredCount >= result->numHunters){
+        stats->mixedWins++;
+    }
+    else{
+        stats->hunterWins++;
+    }
+    if(result->guess == result->actual){
+        stats->correctGuesses++;
+    }
+    else{
+        stats->incorrectGuesses++;
+    }
+    stats->moveStats.moves += result->moveStats.moves;
+    stats->moveStats.contended += result->moveStats.contended;
+    if(stats->runs == 0 || result->length < stats->minLength){
+        stats->minLength = result->length;
+    }
+    if(stats->runs == 0 || result->length > stats->maxLength){
+        stats->maxLength = result->length;
+    }
+    stats->totalLength += result->length;
+    stats->runs++;
+}
+
+/*
+    Function: mergeStats(BatchStats* total, BatchStats* part)
+    Purpose:  Adds the aggregate outcomes of one worker to the totals.
+    Params:
+        Input/Output: BatchStats* total - points to the totals.
+        Input: BatchStats* part - points to the worker's aggregate outcomes.
+    Return: void
+*/
+void mergeStats(BatchStats* total, BatchStats* part){
+    if(part->runs == 0){
+        return;
+    }
+    if(total->runs == 0 || part->minLength < total->minLength){
+        total->minLength = part->minLength;
+    }
+    if(total->runs == 0 || part->maxLength > total->maxLength){
+        total->maxLength = part->maxLength;
+    }
+    total->runs += part->runs;
+    total->fearWins += part->fearWins;
+    total->boredomWins += part->boredomWins;
+    total->mixedWins += part->mixedWins;
+    total->hunterWins += part->hunterWins;
+    total->correctGuesses += part->correctGuesses;
+    total->incorrectGuesses += part->incorrectGuesses;
+    total->totalLength += part->totalLength;
+    total->moveStats.moves += part->moveStats.moves;
+    total->moveStats.contended += part->moveStats.contended;
+    total->pacedTurns += part->pacedTurns;
+    total->lateTotal += part->lateTotal;
+    if(part->lateMax > total->lateMax){
+        total->lateMax = part->lateMax;
+    }
+    for(int i = 0; i < JITTER_BUCKETS; i++){
+        total->lateHist[i] += part->lateHist[i];
+    }
+}
+
+/*
+    Function: printBatchStats(BatchStats* stats, Options* options, double seconds)
+    Purpose:  Prints the aggregate outcomes of a batch.
+    Params:
+        Input: BatchStats* stats - points to the aggregate outcomes.
+        Input: Options* options - stores the options the batch ran with.
+        Input: double seconds - stores the wall clock time the whole batch took.
+    Return: void
+*/
+void printBatchStats(BatchStats* stats, Options* options, double seconds){
+    const char* engineNames[] = {"threads", "virtual", "tick", "lanes", "events"};
+    double runs = (stats->runs > 0) ? stats->runs : 1;
+    printf("=======================================\n");
+    printf("Batch of %d runs on the %s engine (seed %u)\n", stats->runs, engineNames[options->engine], options->seed);
+    printf("=======================================\n");
+    printf("    Ghost wins (all fear):      %8d (%5.1f%%)\n", stats->fearWins, 100.0 * stats->fearWins / runs);
+    printf("    Ghost wins (all boredom):   %8d (%5.1f%%)\n", stats->boredomWins, 100.0 * stats->boredomWins / runs);
+    printf("    Ghost wins (mixed):         %8d (%5.1f%%)\n", stats->mixedWins, 100.0 * stats->mixedWins / runs);
+    printf("    Hunter wins:                %8d (%5.1f%%)\n", stats->hunterWins, 100.0 * stats->hunterWins / runs);
+    printf("    Correct ghostGuess:         %8d (%5.1f%%)\n", stats->correctGuesses, 100.0 * stats->correctGuesses / runs);
+    printf("    Incorrect ghostGuess:       %8d (%5.1f%%)\n", stats->incorrectGuesses, 100.0 * stats->incorrectGuesses / runs);
+    //A hunter win is not a correct guess when some kind of ghost left no evidence the hunters found
+    if(options->ghosts > 1){
+        printf("    (A hunter win only needs every kind of ghost found to be identified, a correct ghostGuess needs every kind in the house)\n");
+    }
+    printf("=======================================\n");
+    //Simulated time for the single-threaded engines, wall clock time for threads
+    printf("    Run length (ms): min %.1f, mean %.1f, max %.1f\n",
+        (double) stats->minLength / USEC_PER_MSEC, stats->totalLength / runs / USEC_PER_MSEC, (double) stats->maxLength / USEC_PER_MSEC);
+    printf("    Throughput: %.1f games/s (%.2f s total)\n", stats->runs / (seconds > 0 ? seconds : 1), seconds);
+    //Only the threaded engine can find a room lock taken
+    printf("    Room moves: %ld (%.0f/s), contended locks %ld (%.2f%% of moves)\n", stats->moveStats.moves,
+        stats->moveStats.moves / (seconds > 0 ? seconds : 1), stats->moveStats.contended,
+        100.0 * stats->moveStats.contended / (stats->moveStats.moves > 0 ? stats->moveStats.moves : 1));
+    if(stats->pacedTurns > 0){
+        printf("    Pacing jitter (us): mean %.1f, p50 < %ld, p99 < %ld, max %ld over %ld hunters' turns\n",
+            (double) stats->lateTotal / stats->pacedTurns, lateBound(stats, 0.5), lateBound(stats, 0.99), stats->lateMax, stats->pacedTurns);
+    }
+}
+
+/*
+    Function: lateBound(BatchStats* stats, double fraction)
+    Purpose:  Reads a percentile of how late the paced hunters' turns started off the lateness histogram.
+    Params:
+        Input: BatchStats* stats - points to the aggregate outcomes of a batch with paced turns.
+        Input: double fraction - stores the fraction of turns, 0.5 for the median.
+    Return: long - returns the upper bound in microseconds of the bucket the percentile falls in.
+*/
+long lateBound(BatchStats* stats, double fraction){
+    long seen = 0;
+    for(int i = 0; i < JITTER_BUCKETS; i++){
+        seen += stats->lateHist[i];
+        if(seen >= fraction * stats->pacedTurns){
+            return 1L << i;
+        }
+    }
+    return 1L << (JITTER_BUCKETS - 1);
+}
@@ -0,0 +1,765 @@
+#include "defs.h"
+
+#define BENCH_BACKLOG          64
+#define BENCH_ITERATIONS       2000000
+#define BENCH_REPEATS          5
+#define BENCH_MAX_RESULTS      64
+#define BENCH_VIRTUAL_GAMES    2000
+#define BENCH_THREAD_GAMES     12
+#define BENCH_LIVE_GAMES       2000
+#define BENCH_LARGE_GAMES      20
+#define BENCH_LARGE_ROOMS      100000
+#define BENCH_GEN_ROOMS        1000000
+#define BENCH_TOLERANCE        10.0
+#define BENCH_TICK_HUNTERS     100000
+
+//Evidence linked list, as rooms stored their evidence before they switched to per-type counters
+typedef struct EvidenceList {
+    struct EvidenceNode* head;
+    struct EvidenceNode* tail;
+    sem_t evidenceMutex;
+    int size;
+} EvidenceList;
+
+//Evidence linked list node
+typedef struct EvidenceNode {
+    EvidenceType data;
+    struct EvidenceNode* next;
+} EvidenceNode;
+
+//One measured number, as written to the JSON report
+typedef struct BenchResult {
+    char name[MAX_STR];
+    char unit[16];
+    double value;
+    int lowerIsBetter;
+} BenchResult;
+
+//Every result of a run, and the options it ran with
+typedef struct BenchSuite {
+    BenchResult results[BENCH_MAX_RESULTS];
+    int count;
+    int scale;              //Iterations and games are divided by this, 1 for a full run
+    const char* filter;     //Only benchmarks whose name contains this run, NULL for all
+} BenchSuite;
+
+//Results are added here so the optimiser cannot drop the calls being timed
+static volatile long benchSink = 0;
+
+//Forward declarations
+double elapsedNs(struct timespec* start, struct timespec* end);
+void listAddEvidence(EvidenceList* evList, EvidenceType evType);
+int listRemoveEvidence(EvidenceList* evList, EvidenceType reader);
+void listFree(EvidenceList* evList);
+double benchEvidenceList(int backlog, int iterations, int buried);
+double benchEvidenceCounters(int backlog, int iterations, int buried);
+int wanted(BenchSuite* suite, const char* name);
+void addResult(BenchSuite* suite, const char* name, const char* unit, double value, int lowerIsBetter);
+void runMicro(BenchSuite* suite);
+void runMacro(BenchSuite* suite);
+double benchMicro(const char* name, int iterations, HouseType* house);
+double benchTick(int kernel, int iterations, HouseType* house);
+double benchGameSetup(int iterations, char hunterNames[][MAX_STR]);
+int isHunterleaving(Hunter* curHunter);     //hunters.c's own helper, timed against the tick engine's kernel
+double benchGames(EngineType engine, int runs, int ghosts);
+double benchSwitches(EngineType engine, int runs);
+double benchJitter(int runs, int live);
+void benchOptions(Options* options, EngineType engine, int runs, int ghosts);
+int writeJson(BenchSuite* suite, const char* path);
+int compareBaseline(BenchSuite* suite, const char* path, double tolerance);
+
+/*
+    Runs the micro and macro benchmarks, prints them, and optionally writes them as JSON or compares them with a baseline.
+*/
+int main(int argc, char* argv[])
+{
+    BenchSuite suite;
+    suite.count = 0;
+    suite.scale = 1;
+    suite.filter = NULL;
+    const char* jsonPath = NULL;
+    const char* baselinePath = NULL;
+    double tolerance = BENCH_TOLERANCE;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--json") == 0 && i + 1 < argc){
+            jsonPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc){
+            baselinePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc){
+            tolerance = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            suite.filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "--quick") == 0){
+            suite.scale = 10;
+        }
+        else{
+            fprintf(stderr, "Usage: %s [--quick] [--filter TEXT] [--json FILE] [--compare BASELINE.json] [--tolerance PCT]\n", argv[0]);
+            return 1;
+        }
+    }
+    l_setEnabled(C_FALSE);
+    seedRandom(1);
+    runMicro(&suite);
+    runMacro(&suite);
+    if(jsonPath != NULL && writeJson(&suite, jsonPath) == C_FALSE){
+        return 1;
+    }
+    if(baselinePath != NULL){
+        return (compareBaseline(&suite, baselinePath, tolerance) == C_TRUE) ? 0 : 1;
+    }
+    return 0;
+}
+
+/*
+    Function: runMicro(BenchSuite* suite)
+    Purpose:  Times the operations the agents perform every turn, each one on its own in a tight loop. Every number is the best of BENCH_REPEATS runs.
+    Params:
+        Input/Output: BenchSuite* suite - points to the suite the results are added to.
+    Return: void
+*/
+void runMicro(BenchSuite* suite){
+    const char* names[] = {"micro.dropEvidence", "micro.removeEvidence", "micro.selectConnectedRoom", "micro.isGhostInRoom",
+                           "micro.isHunterInRoom", "micro.nearestGhostRoom", "micro.randInt", "micro.ghostGuess"};
+    int iterations = BENCH_ITERATIONS / suite->scale;
+    //A game of the built in house, set up but never run, gives the rooms and agents the operations work on
+    char hunterNames[NUM_HUNTERS][MAX_STR];
+    for(int i = 0; i < NUM_HUNTERS; i++){
+        sprintf(hunterNames[i], "Hunter %d", i + 1);
+    }
+    HouseType house;
+    initGame(&house, hunterNames, NUM_HUNTERS, NUM_GHOSTS, 0);
+    printf("Microbenchmarks (ns/op, best of %d):\n", BENCH_REPEATS);
+    for(int i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++){
+        if(wanted(suite, names[i]) == C_FALSE){
+            continue;
+        }
+        double best = 0;
+        for(int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+            double ns = benchMicro(names[i], iterations, &house);
+            if(repeat == 0 || ns < best){
+                best = ns;
+            }
+        }
+        addResult(suite, names[i], "ns/op", best, C_TRUE);
+    }
+    freeProgram(&house);
+    //The evidence store rooms used before, next to the counters they use now
+    const char* storeNames[] = {"micro.evidence.list.mixed", "micro.evidence.counters.mixed", "micro.evidence.list.buried", "micro.evidence.counters.buried"};
+    for(int i = 0; i < 4; i++){
+        int buried = (i >= 2) ? C_TRUE : C_FALSE;
+        if(wanted(suite, storeNames[i]) == C_FALSE){
+            continue;
+        }
+        double best = 0;
+        for(int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+            double ns = (i % 2 == 0) ? benchEvidenceList(BENCH_BACKLOG, iterations, buried) : benchEvidenceCounters(BENCH_BACKLOG, iterations, buried);
+            if(repeat == 0 || ns < best){
+                best = ns;
+            }
+        }
+        addResult(suite, storeNames[i], "ns/op", best, C_TRUE);
+    }
+    //Setting up and tearing down a game of the built in house, which the batch engines do once per game
+    if(wanted(suite, "micro.gameSetup") == C_TRUE){
+        double best = 0;
+        for(int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+            double ns = benchGameSetup(iterations / 100, hunterNames);
+            if(repeat == 0 || ns < best){
+                best = ns;
+            }
+        }
+        addResult(suite, "micro.gameSetup", "ns/op", best, C_TRUE);
+    }
+    //isHunterleaving on every hunter one by one, next to the tick engine's kernel over the same hunters
+    char tickNames[2][MAX_STR];
+    sprintf(tickNames[0], "micro.tick.scalar.%d", BENCH_TICK_HUNTERS);
+    sprintf(tickNames[1], "micro.tick.soa.%d", BENCH_TICK_HUNTERS);
+    if(wanted(suite, tickNames[0]) == C_FALSE && wanted(suite, tickNames[1]) == C_FALSE){
+        return;
+    }
+    char (*crowdNames)[MAX_STR] = malloc(sizeof(*crowdNames) * BENCH_TICK_HUNTERS);
+    for(int i = 0; i < BENCH_TICK_HUNTERS; i++){
+        sprintf(crowdNames[i], "Hunter %d", i + 1);
+    }
+    initGame(&house, crowdNames, BENCH_TICK_HUNTERS, NUM_GHOSTS, 0);
+    free(crowdNames);
+    for(int i = 0; i < 2; i++){
+        if(wanted(suite, tickNames[i]) == C_FALSE){
+            continue;
+        }
+        double best = 0;
+        for(int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+            double ns = benchTick(i, iterations, &house);
+            if(repeat == 0 || ns < best){
+                best = ns;
+            }
+        }
+        addResult(suite, tickNames[i], "ns/hunter", best, C_TRUE);
+    }
+    freeProgram(&house);
+}
+
+/*
+    Function: benchTick(int kernel, int iterations, HouseType* house)
+    Purpose:  Times the fear and boredom update of every hunter of a game, with the hunters spread over all the rooms.
+    Params:
+        Input: int kernel - stores C_TRUE to time tickKernel, or C_FALSE to call isHunterleaving per hunter.
+        Input: int iterations - stores roughly how many hunter updates are timed, rounded to whole passes over the hunters.
+        Input/Output: HouseType* house - points to a set up game, its hunters' fear and boredom are reset first.
+    Return: double - returns the average time of one hunter's update in nanoseconds.
+*/
+double benchTick(int kernel, int iterations, HouseType* house){
+    int passes = (iterations / house->numHunters > 0) ? iterations / house->numHunters : 1;
+    for(int i = 0; i < house->numHunters; i++){
+        house->curHunters[i].curRoom = house->graph.rooms[i % house->graph.numRooms];
+        house->curHunters[i].fear = 0;
+        house->curHunters[i].boredom = 0;
+    }
+    //The arrays come from the game's arena and are released when the timing is done
+    ArenaMark mark = arenaMark(house->arena);
+    HunterSoA soa;
+    initHunterSoA(&soa, house);
+    long sink = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int pass = 0; pass < passes; pass++){
+        if(kernel == C_TRUE){
+            sink += tickKernel(&soa);
+        }
+        else{
+            for(int i = 0; i < house->numHunters; i++){
+                sink += isHunterleaving(&(house->curHunters[i]));
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchSink += sink;
+    arenaRelease(house->arena, mark);
+    return elapsedNs(&start, &end) / ((double) passes * house->numHunters);
+}
+
+/*
+    Function: benchGameSetup(int iterations, char hunterNames[][MAX_STR])
+    Purpose:  Times initGame and freeProgram of the built in house, one game after another on the calling thread.
+    Params:
+        Input: int iterations - stores how many games are set up and torn down.
+        Input: char hunterNames[][MAX_STR] - stores the names of the NUM_HUNTERS hunters.
+    Return: double - returns the average time of one setup and teardown in nanoseconds.
+*/
+double benchGameSetup(int iterations, char hunterNames[][MAX_STR]){
+    HouseType house;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < iterations; i++){
+        initGame(&house, hunterNames, NUM_HUNTERS, NUM_GHOSTS, i);
+        freeProgram(&house);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsedNs(&start, &end) / iterations;
+}
+
+/*
+    Function: benchMicro(const char* name, int iterations, HouseType* house)
+    Purpose:  Times one microbenchmark.
+    Params:
+        Input: const char* name - stores the name of the benchmark, one of those listed in runMicro.
+        Input: int iterations - stores how many operations are timed.
+        Input/Output: HouseType* house - points to a set up game whose rooms and first hunter are used.
+    Return: double - returns the average time of one operation in nanoseconds.
+*/
+double benchMicro(const char* name, int iterations, HouseType* house){
+    Hunter* hunter = &(house->curHunters[0]);
+    Room* room = house->graph.rooms[1];
+    EvidenceType found[DESIRED_EVIDENCE_COUNT];
+    long sink = 0;
+    struct timespec start, end;
+    //removeEvidence needs evidence to take, it is left in the room before the clock starts
+    if(strcmp(name, "micro.removeEvidence") == 0){
+        hunter->curRoom = room;
+        room->evidence.counts[POLTERGEIST][hunter->reader] += iterations;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(strcmp(name, "micro.dropEvidence") == 0){
+        for(int i = 0; i < iterations; i++){
+            dropEvidence(&(room->evidence), POLTERGEIST, i % EV_COUNT);
+        }
+    }
+    else if(strcmp(name, "micro.removeEvidence") == 0){
+        for(int i = 0; i < iterations; i++){
+            sink += removeEvidence(hunter);
+        }
+    }
+    else if(strcmp(name, "micro.selectConnectedRoom") == 0){
+        for(int i = 0; i < iterations; i++){
+            room = selectConnectedRoom(room);
+        }
+        sink += room->id;
+    }
+    else if(strcmp(name, "micro.isGhostInRoom") == 0){
+        for(int i = 0; i < iterations; i++){
+            sink += isGhostInRoom(house->graph.rooms[i % house->graph.numRooms]);
+        }
+    }
+    else if(strcmp(name, "micro.isHunterInRoom") == 0){
+        for(int i = 0; i < iterations; i++){
+            sink += isHunterInRoom(house->graph.rooms[i % house->graph.numRooms]);
+        }
+    }
+    else if(strcmp(name, "micro.nearestGhostRoom") == 0){
+        //Searched from every room in turn, for the ghosts where initGame left them
+        int distance;
+        for(int i = 0; i < iterations; i++){
+            nearestGhostRoom(house->graph.rooms[i % house->graph.numRooms], &distance);
+            sink += distance;
+        }
+    }
+    else if(strcmp(name, "micro.randInt") == 0){
+        for(int i = 0; i < iterations; i++){
+            sink += randInt(0, 3);
+        }
+    }
+    else if(strcmp(name, "micro.ghostGuess") == 0){
+        //Every set of three evidence types in turn, each one names a different ghost
+        for(int i = 0; i < iterations; i++){
+            int missing = i % EV_COUNT;
+            for(int j = 0, k = 0; j < EV_COUNT; j++){
+                if(j != missing){
+                    found[k++] = j;
+                }
+            }
+            sink += ghostGuess(DESIRED_EVIDENCE_COUNT, found);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchSink += sink;
+    for(int i = 0; i < GHOST_COUNT; i++){
+        for(int j = 0; j < EV_COUNT; j++){
+            house->graph.rooms[1]->evidence.counts[i][j] = 0;
+        }
+    }
+    hunter->curRoom = house->graph.rooms[0];
+    return elapsedNs(&start, &end) / iterations;
+}
+
+/*
+    Function: runMacro(BenchSuite* suite)
+    Purpose:  Times whole games on each engine in the built in house and in large generated houses, and the generation of a large house.
+    Params:
+        Input/Output: BenchSuite* suite - points to the suite the results are added to.
+    Return: void
+*/
+void runMacro(BenchSuite* suite){
+    printf("Macrobenchmarks:\n");
+    if(wanted(suite, "macro.virtual.builtin") == C_TRUE){
+        addResult(suite, "macro.virtual.builtin", "games/s", benchGames(ENGINE_VIRTUAL, BENCH_VIRTUAL_GAMES / suite->scale, NUM_GHOSTS), C_FALSE);
+    }
+    if(wanted(suite, "macro.virtual.builtin.4ghosts") == C_TRUE){
+        addResult(suite, "macro.virtual.builtin.4ghosts", "games/s", benchGames(ENGINE_VIRTUAL, BENCH_VIRTUAL_GAMES / suite->scale, 4), C_FALSE);
+    }
+    if(wanted(suite, "macro.tick.builtin") == C_TRUE){
+        addResult(suite, "macro.tick.builtin", "games/s", benchGames(ENGINE_TICK, BENCH_VIRTUAL_GAMES / suite->scale, NUM_GHOSTS), C_FALSE);
+    }
+    if(wanted(suite, "macro.lanes.builtin") == C_TRUE){
+        addResult(suite, "macro.lanes.builtin", "games/s", benchGames(ENGINE_LANES, BENCH_VIRTUAL_GAMES / suite->scale, NUM_GHOSTS), C_FALSE);
+    }
+    if(wanted(suite, "macro.threads.builtin") == C_TRUE){
+        int runs = BENCH_THREAD_GAMES / suite->scale;
+        addResult(suite, "macro.threads.builtin", "games/s", benchGames(ENGINE_THREADS, (runs > 0) ? runs : 1, NUM_GHOSTS), C_FALSE);
+    }
+    if(wanted(suite, "macro.events.builtin") == C_TRUE){
+        int runs = BENCH_THREAD_GAMES / suite->scale;
+        addResult(suite, "macro.events.builtin", "games/s", benchGames(ENGINE_EVENTS, (runs > 0) ? runs : 1, NUM_GHOSTS), C_FALSE);
+    }
+    //Every game of the batch is live at once on the one timer wheel
+    if(wanted(suite, "macro.events.jitter") == C_TRUE){
+        int runs = BENCH_LIVE_GAMES / suite->scale;
+        addResult(suite, "macro.events.jitter", "us", benchJitter((runs > 0) ? runs : 1, (runs > 0) ? runs : 1), C_TRUE);
+    }
+    //The two real time engines play games of the same length, what differs is how often they wake the CPU
+    const char* switchNames[] = {"macro.threads.switches", "macro.events.switches"};
+    EngineType switchEngines[] = {ENGINE_THREADS, ENGINE_EVENTS};
+    for(int i = 0; i < 2; i++){
+        if(wanted(suite, switchNames[i]) == C_TRUE){
+            int runs = BENCH_THREAD_GAMES / suite->scale;
+            addResult(suite, switchNames[i], "switches/game", benchSwitches(switchEngines[i], (runs > 0) ? runs : 1), C_TRUE);
+        }
+    }
+    //Large houses, generated once and shared by every game like a house file
+    const char* specs[] = {"grid", "smallworld"};
+    for(int i = 0; i < 2; i++){
+        char name[MAX_STR];
+        sprintf(name, "macro.virtual.%s.%d", specs[i], BENCH_LARGE_ROOMS);
+        if(wanted(suite, name) == C_FALSE){
+            continue;
+        }
+        char text[MAX_STR];
+        sprintf(text, "%s:%d", specs[i], BENCH_LARGE_ROOMS);
+        GenSpec spec;
+        HouseDesc desc;
+        parseGenSpec(text, &spec);
+        generateHouse(&spec, &desc);
+        if(setLoadedHouse(&desc, "generated house") == C_FALSE){
+            continue;
+        }
+        int runs = BENCH_LARGE_GAMES / suite->scale;
+        addResult(suite, name, "games/s", benchGames(ENGINE_VIRTUAL, (runs > 0) ? runs : 1, NUM_GHOSTS), C_FALSE);
+        unloadHouseFile();
+    }
+    char name[MAX_STR];
+    sprintf(name, "macro.generate.smallworld.%d", BENCH_GEN_ROOMS / suite->scale);
+    if(wanted(suite, name) == C_TRUE){
+        char text[MAX_STR];
+        sprintf(text, "smallworld:%d:6:power", BENCH_GEN_ROOMS / suite->scale);
+        GenSpec spec;
+        HouseDesc desc;
+        parseGenSpec(text, &spec);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        generateHouse(&spec, &desc);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        freeHouseDesc(&desc);
+        addResult(suite, name, "ms", elapsedNs(&start, &end) / 1e6, C_TRUE);
+    }
+}
+
+/*
+    Function: benchSwitches(EngineType engine, int runs)
+    Purpose:  Plays a seeded batch as benchGames does and counts the context switches of the whole process while it runs.
+    Params:
+        Input: EngineType engine - stores which engine plays the games.
+        Input: int runs - stores the number of games.
+    Return: double - returns the average number of voluntary and involuntary context switches per game.
+*/
+double benchSwitches(EngineType engine, int runs){
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    benchGames(engine, runs, NUM_GHOSTS);
+    getrusage(RUSAGE_SELF, &after);
+    long switches = (after.ru_nvcsw - before.ru_nvcsw) + (after.ru_nivcsw - before.ru_nivcsw);
+    return (double) switches / runs;
+}
+
+/*
+    Function: benchGames(EngineType engine, int runs, int ghosts)
+    Purpose:  Plays a seeded batch on the run farm, exactly as '--runs' does, and measures its throughput.
+    Params:
+        Input: EngineType engine - stores which engine plays the games.
+        Input: int runs - stores the number of games.
+        Input: int ghosts - stores the number of ghosts in every game.
+    Return: double - returns the number of games played per second of wall clock time.
+*/
+double benchGames(EngineType engine, int runs, int ghosts){
+    Options options;
+    benchOptions(&options, engine, runs, ghosts);
+    BatchStats stats;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    runFarm(&options, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return stats.runs / (elapsedNs(&start, &end) / 1e9);
+}
+
+/*
+    Function: benchJitter(int runs, int live)
+    Purpose:  Plays a seeded batch on the events engine with many games live on one thread, and measures how late their
+              hunters' turns start on the wall clock.
+    Params:
+        Input: int runs - stores the number of games.
+        Input: int live - stores the number of games each worker paces at once.
+    Return: double - returns the mean lateness of a hunters' turn in microseconds.
+*/
+double benchJitter(int runs, int live){
+    Options options;
+    benchOptions(&options, ENGINE_EVENTS, runs, NUM_GHOSTS);
+    options.workers = 1;
+    options.live = live;
+    BatchStats stats;
+    runFarm(&options, &stats);
+    return (stats.pacedTurns > 0) ? (double) stats.lateTotal / stats.pacedTurns : 0.0;
+}
+
+/*
+    Function: benchOptions(Options* options, EngineType engine, int runs, int ghosts)
+    Purpose:  Sets up the options of a seeded batch with the builtin house and no log output.
+    Params:
+        Output: Options* options - points to the options being set up.
+        Input: EngineType engine - stores which engine plays the games.
+        Input: int runs - stores the number of games.
+        Input: int ghosts - stores the number of ghosts in every game.
+    Return: void
+*/
+void benchOptions(Options* options, EngineType engine, int runs, int ghosts){
+    memset(options, 0, sizeof(Options));
+    options->runs = runs;
+    options->seed = 1;
+    options->seeded = C_TRUE;
+    options->engine = engine;
+    options->hunters = NUM_HUNTERS;
+    options->ghosts = ghosts;
+    options->logMode = LOG_SYNC;
+    options->live = LIVE_GAMES;
+}
+
+/*
+    Function: wanted(BenchSuite* suite, const char* name)
+    Purpose:  Tells whether a benchmark passes the suite's filter.
+    Params:
+        Input: BenchSuite* suite - points to the suite.
+        Input: const char* name - stores the name of the benchmark.
+    Return: int - returns C_TRUE if the benchmark should run, or C_FALSE otherwise
+*/
+int wanted(BenchSuite* suite, const char* name){
+    return (suite->filter == NULL || strstr(name, suite->filter) != NULL) ? C_TRUE : C_FALSE;
+}
+
+/*
+    Function: addResult(BenchSuite* suite, const char* name, const char* unit, double value, int lowerIsBetter)
+    Purpose:  Records a result and prints it.
+    Params:
+        Input/Output: BenchSuite* suite - points to the suite.
+        Input: const char* name - stores the name of the benchmark.
+        Input: const char* unit - stores the unit of the value.
+        Input: double value - stores the measured value.
+        Input: int lowerIsBetter - C_TRUE if a smaller value is an improvement.
+    Return: void
+*/
+void addResult(BenchSuite* suite, const char* name, const char* unit, double value, int lowerIsBetter){
+    printf("    %-36s %12.2f %s\n", name, value, unit);
+    fflush(stdout);
+    if(suite->count == BENCH_MAX_RESULTS){
+        return;
+    }
+    BenchResult* result = &(suite->results[suite->count++]);
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    snprintf(result->unit, sizeof(result->unit), "%s", unit);
+    result->value = value;
+    result->lowerIsBetter = lowerIsBetter;
+}
+
+/*
+    Function: writeJson(BenchSuite* suite, const char* path)
+    Purpose:  Writes every result as JSON, one result per line so compareBaseline can read it back without a JSON parser.
+    Params:
+        Input: BenchSuite* suite - points to the suite.
+        Input: const char* path - stores the path of the JSON file.
+    Return: int - returns C_TRUE if the file was written, or C_FALSE otherwise
+*/
+int writeJson(BenchSuite* suite, const char* path){
+    FILE* file = fopen(path, "w");
+    if(file == NULL){
+        fprintf(stderr, "Could not create '%s'\n", path);
+        return C_FALSE;
+    }
+    fprintf(file, "{\n  \"scale\": %d,\n  \"results\": [\n", suite->scale);
+    for(int i = 0; i < suite->count; i++){
+        BenchResult* result = &(suite->results[i]);
+        fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.4f, \"lower_is_better\": %s}%s\n",
+            result->name, result->unit, result->value, result->lowerIsBetter ? "true" : "false", (i + 1 < suite->count) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return C_TRUE;
+}
+
+/*
+    Function: compareBaseline(BenchSuite* suite, const char* path, double tolerance)
+    Purpose:  Compares every result with the same benchmark in a JSON file written by an earlier run, and flags the ones
+              that got worse by more than the tolerance.
+    Params:
+        Input: BenchSuite* suite - points to the suite.
+        Input: const char* path - stores the path of the baseline JSON file.
+        Input: double tolerance - stores the change in percent that is still treated as noise.
+    Return: int - returns C_TRUE if nothing regressed, or C_FALSE if something did or the baseline could not be read
+*/
+int compareBaseline(BenchSuite* suite, const char* path, double tolerance){
+    FILE* file = fopen(path, "r");
+    if(file == NULL){
+        fprintf(stderr, "Could not open baseline '%s'\n", path);
+        return C_FALSE;
+    }
+    BenchResult baseline[BENCH_MAX_RESULTS];
+    int count = 0;
+    char line[4 * MAX_STR];
+    while(count < BENCH_MAX_RESULTS && fgets(line, sizeof(line), file) != NULL){
+        BenchResult* entry = &(baseline[count]);
+        if(sscanf(line, " {\"name\": \"%63[^\"]\", \"unit\": \"%15[^\"]\", \"value\": %lf", entry->name, entry->unit, &(entry->value)) == 3){
+            count++;
+        }
+    }
+    fclose(file);
+    int regressions = 0;
+    printf("Compared with %s (tolerance %.1f%%):\n", path, tolerance);
+    for(int i = 0; i < suite->count; i++){
+        BenchResult* result = &(suite->results[i]);
+        BenchResult* base = NULL;
+        for(int j = 0; j < count; j++){
+            if(strcmp(baseline[j].name, result->name) == 0){
+                base = &(baseline[j]);
+            }
+        }
+        if(base == NULL || base->value <= 0){
+            printf("    %-36s %12s\n", result->name, "new");
+            continue;
+        }
+        //Positive change is always an improvement, whichever direction the unit counts in
+        double change = 100.0 * (result->value - base->value) / base->value;
+        if(result->lowerIsBetter){
+            change = -change;
+        }
+        int regressed = (change < -tolerance);
+        regressions += regressed;
+        printf("    %-36s %+11.1f%% %s\n", result->name, change, regressed ? "REGRESSION" : "");
+    }
+    printf("%d regression%s\n", regressions, (regressions == 1) ? "" : "s");
+    return (regressions == 0) ? C_TRUE : C_FALSE;
+}
+
+/*
+    Function: benchEvidenceList(int backlog, int iterations, int buried)
+    Purpose:  Times the linked list evidence store rooms used before, with the same locking as the game.
+    Params:
+        Input: int backlog - stores how many pieces of evidence are already lying in the room.
+        Input: int iterations - stores how many drop/pickup pairs are timed.
+        Input: int buried - C_TRUE if the backlog never matches the pickups, as when evidence piles up for a hunter who is elsewhere.
+    Return: double - returns the average time of one drop/pickup pair in nanoseconds.
+*/
+double benchEvidenceList(int backlog, int iterations, int buried){
+    EvidenceList evList = {NULL, NULL, {{0}}, 0};
+    sem_init(&(evList.evidenceMutex), 0, 1);
+    for(int i = 0; i < backlog; i++){
+        listAddEvidence(&evList, buried ? randInt(0, EV_COUNT - 1) : randInt(0, EV_COUNT));
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < iterations; i++){
+        listAddEvidence(&evList, buried ? EV_COUNT - 1 : i % EV_COUNT);
+        listRemoveEvidence(&evList, buried ? EV_COUNT - 1 : (i + 1) % EV_COUNT);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    listFree(&evList);
+    return elapsedNs(&start, &end) / iterations;
+}
+
+/*
+    Function: benchEvidenceCounters(int backlog, int iterations, int buried)
+    Purpose:  Times the per-type counters rooms use now, through the same functions the ghost and hunters call.
+    Params:
+        Input: int backlog - stores how many pieces of evidence are already lying in the room.
+        Input: int iterations - stores how many drop/pickup pairs are timed.
+        Input: int buried - C_TRUE if the backlog never matches the pickups, as when evidence piles up for a hunter who is elsewhere.
+    Return: double - returns the average time of one drop/pickup pair in nanoseconds.
+*/
+double benchEvidenceCounters(int backlog, int iterations, int buried){
+    Arena* arena = gameArena();
+    ArenaMark mark = arenaMark(arena);
+    Room* room = createRoom(arena, "Bench");
+    Hunter hunter;
+    hunter.curRoom = room;
+    for(int i = 0; i < backlog; i++){
+        dropEvidence(&(room->evidence), POLTERGEIST, buried ? randInt(0, EV_COUNT - 1) : randInt(0, EV_COUNT));
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < iterations; i++){
+        dropEvidence(&(room->evidence), POLTERGEIST, buried ? EV_COUNT - 1 : i % EV_COUNT);
+        hunter.reader = buried ? EV_COUNT - 1 : (i + 1) % EV_COUNT;
+        removeEvidence(&hunter);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    arenaRelease(arena, mark);
+    return elapsedNs(&start, &end) / iterations;
+}
+
+/*
+    Function: listAddEvidence(EvidenceList* evList, EvidenceType evType)
+    Purpose:  Appends a piece of evidence to a list the way rooms used to, one malloc per piece.
+    Params:
+        Input/Output: EvidenceList* evList - points to the list.
+        Input: EvidenceType evType - stores the evidence type being added.
+    Return: void
+*/
+void listAddEvidence(EvidenceList* evList, EvidenceType evType){
+    if(sem_wait(&(evList->evidenceMutex)) == 0){
+        EvidenceNode* new = (EvidenceNode*) malloc(sizeof(EvidenceNode));
+        new->data = evType;
+        new->next = NULL;
+        if(evList->head == NULL){
+            evList->head = new;
+        }
+        else{
+            evList->tail->next = new;
+        }
+        evList->tail = new;
+        evList->size += 1;
+        sem_post(&(evList->evidenceMutex));
+    }
+}
+
+/*
+    Function: listRemoveEvidence(EvidenceList* evList, EvidenceType reader)
+    Purpose:  Removes the first piece of evidence of the given type the way rooms used to, scanning and freeing a node.
+    Params:
+        Input/Output: EvidenceList* evList - points to the list.
+        Input: EvidenceType reader - stores the evidence type being looked for.
+    Return: int - returns C_TRUE if a piece of evidence was removed, or C_FALSE otherwise
+*/
+int listRemoveEvidence(EvidenceList* evList, EvidenceType reader){
+    int found = C_FALSE;
+    if(sem_wait(&(evList->evidenceMutex)) == 0){
+        EvidenceNode* prev = NULL;
+        EvidenceNode* curNode = evList->head;
+        while(curNode != NULL){
+            if(curNode->data == reader){
+                if(prev == NULL){
+                    evList->head = curNode->next;
+                }
+                else{
+                    prev->next = curNode->next;
+                }
+                if(curNode == evList->tail){
+                    evList->tail = prev;
+                }
+                free(curNode);
+                evList->size -= 1;
+                found = C_TRUE;
+                break;
+            }
+            prev = curNode;
+            curNode = curNode->next;
+        }
+        sem_post(&(evList->evidenceMutex));
+    }
+    return found;
+}
+
+/*
+    Function: listFree(EvidenceList* evList)
+    Purpose:  Frees every node of a list.
+    Params:
+        Input/Output: EvidenceList* evList - points to the list.
+    Return: void
+*/
+void listFree(EvidenceList* evList){
+    EvidenceNode* curNode = evList->head;
+    while(curNode != NULL){
+        EvidenceNode* tempNext = curNode->next;
+        free(curNode);
+        curNode = tempNext;
+    }
+}
+
+/*
+    Function: elapsedNs(struct timespec* start, struct timespec* end)
+    Purpose:  Computes the time between two clock readings.
+    Params:
+        Input: struct timespec* start - points to the earlier reading.
+        Input: struct timespec* end - points to the later reading.
+    Return: double - returns the time between the readings in nanoseconds.
+*/
+double elapsedNs(struct timespec* start, struct timespec* end){
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
@@ -5,33 +5,202 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
 
 #define MAX_STR                64
 #define MAX_RUNS               50
-#define BOREDOM_MAX            100
 #define C_TRUE                 1
 #define C_FALSE                0
+//The rules of the game can be changed at build time, e.g. make DEFS="-DBOREDOM_MAX=20 -DFEAR_MAX=4"
+#ifndef BOREDOM_MAX
+#define BOREDOM_MAX            100
+#endif
+#ifndef HUNTER_WAIT
 #define HUNTER_WAIT            5000
+#endif
+#ifndef GHOST_WAIT
 #define GHOST_WAIT             600
-#define NUM_HUNTERS            4
+#endif
+#define NUM_HUNTERS            4          //Default number of hunters, --hunters changes it
+#define MAX_HUNTERS            100000
+#define NUM_GHOSTS             1          //Default number of ghosts, --ghosts changes it
+#define MAX_GHOSTS             10000
+#ifndef FEAR_MAX
 #define FEAR_MAX               10
+#endif
 #define LOGGING                C_TRUE
+#ifndef FEAR_INCREMENT
 #define FEAR_INCREMENT         1
+#endif
 #define DESIRED_EVIDENCE_COUNT 3
+#define LOG_RING_SIZE          1024
+#define LOG_BATCH_BYTES        65536
+#define LOG_IDLE_WAIT          1000
+#define TRACE_MAGIC            "GHTR"
+#define TRACE_VERSION          2
+#define TRACE_GAME_BEGIN       0x01
+#define TRACE_GAME_END         0x02
+#define TRACE_EVENT            0x10
+#define TRACE_AGENT_ESCAPE     0x0f
+#define TRACE_INITIAL_BYTES    4096
+#define RNG_STREAM_HOUSE       0
+#define RNG_STREAM_HUNTER      1
+#define RNG_STREAM_GHOST       0x10000
+#define HOUSE_MAGIC            "GHHS"
+#define HOUSE_VERSION          1
+#define HOUSE_LINE_MAX         256
+#define GEN_MAX_ROOMS          100000000
+#define GEN_MAX_DEGREE         64
+#define GEN_REWIRE_ONE_IN      10
+#define RNG_RUN_GENERATOR      -2
+#define USEC_PER_MSEC          1000
+#define INSTR_BUCKETS          40         //Histogram buckets, bucket b counts times below 2^b ns
+#define INSTR_TOP_ROOMS        10         //Rooms listed per lock kind in the instrumentation report
+#define SOA_LANES              4          //Hunters updated together by the tick engine's kernel, 4 ints fill an SSE2 or NEON register
+#define LANES                  16         //Games played side by side by the lanes engine, one per 32-bit lane of an AVX-512 register
+#define LANES_MAX_ROOMS        4096       //Larger houses are played on the tick engine, the lanes keep counters for every room
+#define ARENA_CHUNK_BYTES      65536      //Smallest block a game arena takes from the heap
+#define ARENA_ALIGN            64         //Every arena allocation starts on its own cache line
+#define LIVE_GAMES             1000       //Games each worker paces at once on the events engine, --live changes it
+#define MAX_LIVE               1000000
+#define WHEEL_SLOTS            512        //Slots of a worker's timer wheel, together they span more than HUNTER_WAIT
+#define WHEEL_TICK             20         //Microseconds covered by one slot of the timer wheel
+#define WHEEL_ARENA_BYTES      16384      //Smallest block of a paced game's own arena, a game of the built in house fits in one
+#define JITTER_BUCKETS         24         //Histogram buckets, bucket b counts turns less than 2^b microseconds late
+#define OCCUPANCY_BITS         64         //Rooms per word of a house's occupancy bitmaps
+#define EXACT_MAX_ROOMS        16         //Rooms the exact solver's evidence bitmask has room for, EV_COUNT bits per room
+#define EXACT_MAX_HUNTERS      8
+#define EXACT_MAX_STATES       4000000    //States the exact solver keeps at once before it gives up on a house
+
+//Build with 'make clean && make INSTRUMENT=1' to time every room lock and agent action, see instrument.c
+#ifdef INSTRUMENT
+#define LOCK(lock)              instrLock(lock)
+#define TRYLOCK(lock)           instrTryLock(lock)
+#define UNLOCK(lock)            instrUnlock(lock)
+#define INSTR_TIME(fn, stmt)    do { long instrStart = instrNow(); stmt; instrCall((fn), instrStart); } while(0)
+#define INSTR_INIT()            instrInit()
+#define INSTR_BEGIN_GAME(house) instrBeginGame(house)
+#else
+#define LOCK(lock)              pthread_mutex_lock(&((lock)->mutex))
+#define TRYLOCK(lock)           pthread_mutex_trylock(&((lock)->mutex))
+#define UNLOCK(lock)            pthread_mutex_unlock(&((lock)->mutex))
+#define INSTR_TIME(fn, stmt)    do { stmt; } while(0)
+#define INSTR_INIT()
+#define INSTR_BEGIN_GAME(house)
+#endif
 
 typedef enum EvidenceType EvidenceType;
 typedef enum GhostClass GhostClass;
+typedef enum EngineType EngineType;
+typedef enum LogMode LogMode;
+typedef enum GenTopology GenTopology;
+typedef enum GenDistribution GenDistribution;
+typedef enum LockKind LockKind;
+typedef enum InstrFunction InstrFunction;
+
+//The evidence types and ghost classes, everything else about them is generated from these two tables.
+//A class leaves DESIRED_EVIDENCE_COUNT evidence types, and no two classes may leave the same ones
+#define EVIDENCE_TABLE(X) \
+    X(EMF,          "EMF") \
+    X(TEMPERATURE,  "TEMPERATURE") \
+    X(FINGERPRINTS, "FINGERPRINTS") \
+    X(SOUND,        "SOUND")
+
+#define GHOST_TABLE(X) \
+    X(POLTERGEIST,  "Poltergeist",  EMF,            TEMPERATURE,    FINGERPRINTS) \
+    X(BANSHEE,      "Banshee",      EMF,            TEMPERATURE,    SOUND) \
+    X(BULLIES,      "Bullies",      EMF,            FINGERPRINTS,   SOUND) \
+    X(PHANTOM,      "Phantom",      TEMPERATURE,    FINGERPRINTS,   SOUND)
+
+#define AS_ENUM(name, ...)              name,
+#define AS_NAME(name, text, ...)        text,
+#define AS_EVIDENCE(name, text, ...)    { __VA_ARGS__ },
+#define AS_MASK(name, text, a, b, c)    (1u << (a)) | (1u << (b)) | (1u << (c)),
+#define AS_LOOKUP(name, text, a, b, c)  [(1u << (a)) | (1u << (b)) | (1u << (c))] = (name) + 1,
+#define AS_CASE(name, text, a, b, c)    case (1u << (a)) | (1u << (b)) | (1u << (c)): break;
+#define AS_DISTINCT(name, text, a, b, c) \
+    _Static_assert((a) != (b) && (a) != (c) && (b) != (c), #name " must leave three different evidence types");
 
-enum EvidenceType { EMF, TEMPERATURE, FINGERPRINTS, SOUND, EV_COUNT, EV_UNKNOWN };
-enum GhostClass { POLTERGEIST, BANSHEE, BULLIES, PHANTOM, GHOST_COUNT, GH_UNKNOWN };
+enum EvidenceType { EVIDENCE_TABLE(AS_ENUM) EV_COUNT, EV_UNKNOWN };
+enum GhostClass { GHOST_TABLE(AS_ENUM) GHOST_COUNT, GH_UNKNOWN };
+
+//The found evidence of every class is one bit per class and type in an unsigned int (SharedEvidence, LaneWorld, GameResult)
+_Static_assert(GHOST_COUNT * EV_COUNT <= 32, "GHOST_COUNT * EV_COUNT evidence bits must fit in 32 bits");
+GHOST_TABLE(AS_DISTINCT)
+//Never called. Two classes leaving the same types are duplicate case labels, which is an error on every build
+static inline void checkGhostTable(unsigned int evidence){
+    switch(evidence){
+        GHOST_TABLE(AS_CASE)
+        default: break;
+    }
+}
+
+static const char* const evidenceNames[EV_COUNT] = { EVIDENCE_TABLE(AS_NAME) };
+static const char* const ghostNames[GHOST_COUNT] = { GHOST_TABLE(AS_NAME) };
+//The evidence types each class leaves, leaveEvidence draws one of them
+static const int ghostEvidence[GHOST_COUNT][DESIRED_EVIDENCE_COUNT] = { GHOST_TABLE(AS_EVIDENCE) };
+//The same types as one bit per EvidenceType
+static const unsigned int ghostEvidenceMask[GHOST_COUNT] = { GHOST_TABLE(AS_MASK) };
+//Evidence bits -> GhostClass + 1 of the class leaving exactly those types, 0 for sets no class leaves
+static const unsigned char ghostByEvidence[1 << EV_COUNT] = { GHOST_TABLE(AS_LOOKUP) };
+enum EngineType { ENGINE_THREADS, ENGINE_VIRTUAL, ENGINE_TICK, ENGINE_LANES, ENGINE_EVENTS };
+enum LogMode { LOG_SYNC, LOG_ASYNC_BLOCK, LOG_ASYNC_DROP };
+enum GenTopology { GEN_GRID, GEN_TREE, GEN_SMALL_WORLD, GEN_CLUSTERS };
+enum GenDistribution { GEN_UNIFORM, GEN_POWER };
+enum LockKind { LOCK_HUNTERS, LOCK_GHOSTS, LOCK_EVIDENCE, LOCK_KINDS };
+enum InstrFunction { FN_HUNTER_LEAVING, FN_COLLECT_EVIDENCE, FN_MOVE_HUNTER, FN_REVIEW_EVIDENCE,
+                     FN_GHOST_LEAVING, FN_LEAVE_EVIDENCE, FN_MOVE_GHOST, FN_COUNT };
+enum LogEvent { EVT_HUNTER_INIT, EVT_HUNTER_MOVE, EVT_HUNTER_REVIEW, EVT_HUNTER_COLLECT, EVT_HUNTER_EXIT,
+                EVT_GHOST_INIT, EVT_GHOST_MOVE, EVT_GHOST_EVIDENCE, EVT_GHOST_EXIT };
 enum LoggerDetails { LOG_FEAR, LOG_BORED, LOG_EVIDENCE, LOG_SUFFICIENT, LOG_INSUFFICIENT, LOG_UNKNOWN };
 
 //Define stuctures
+//xoshiro256** generator state, one per agent so a game replays the same for a given seed
+typedef struct Rng{
+    uint64_t s[4];
+} Rng;
+
+//Timing of one lock or agent action, shared by every game of the process. Only exists in instrumented builds
+typedef struct InstrStats{
+    atomic_long count;
+    atomic_long contended;                  //Acquisitions that found the lock taken
+    atomic_long waitNs;
+    atomic_long holdNs;
+    atomic_long waitHist[INSTR_BUCKETS];    //For actions, the histogram of their latency
+    atomic_long holdHist[INSTR_BUCKETS];
+} InstrStats;
+
+//Mutex of a room. Instrumented builds also point it at the statistics of its room and kind
+typedef struct RoomLock{
+    pthread_mutex_t mutex;
+#ifdef INSTRUMENT
+    InstrStats* stats;
+    long lockedAt;          //When the holder acquired it, only touched by the holder
+#endif
+} RoomLock;
+
+//Room moves an agent made and how many of their lock acquisitions found the lock taken, only written by the agent itself
+typedef struct MoveStats{
+    long moves;
+    long contended;
+} MoveStats;
+
 //Ghost struct
 typedef struct Ghost{
   GhostClass ghostType;
   struct Room* curRoom;
   int boredomTimer; 
+  int id;
+  struct House* house;
+  Rng rng;
+  MoveStats moveStats;
 } Ghost;
 
 //Room linked list
@@ -41,93 +210,540 @@ typedef struct RoomList {
     int size;
 } RoomList;
 
+//Block of memory owned by an arena. Blocks stay in the arena's list after a release and are reused by the next game
+typedef struct ArenaChunk{
+    struct ArenaChunk* next;
+    size_t size;            //Bytes after the header, which is ARENA_ALIGN bytes
+} ArenaChunk;
+
+//Bump allocator every allocation of a game comes from. Nothing is freed on its own: freeProgram hands everything
+//allocated since the game started back at once by moving the arena back to a mark
+typedef struct Arena{
+    ArenaChunk* head;
+    ArenaChunk* current;    //Block being allocated from, NULL before the first allocation
+    size_t used;            //Bytes of current handed out
+    long heapCalls;         //Blocks taken from the heap so far, it stops growing once the arena is warm
+    size_t chunkBytes;      //Smallest block taken from the heap, 0 for ARENA_CHUNK_BYTES
+} Arena;
+
+//Point an arena can be moved back to, everything allocated after it is released
+typedef struct ArenaMark{
+    ArenaChunk* chunk;
+    size_t used;
+} ArenaMark;
+
 //Room linked list node
 typedef struct RoomNode {
   struct Room* data;
   struct RoomNode* next;
 } RoomNode;
 
-//Evidence linked list
-typedef struct EvidenceList {
-    struct EvidenceNode* head;
-    struct EvidenceNode* tail;
-    sem_t evidenceMutex;
-    int size;
-} EvidenceList;
+//Evidence shared by all hunters, one bit per ghost class and evidence type so collecting and reviewing never take a lock
+typedef struct SharedEvidence {
+    atomic_uint found;                      //Bit (class * EV_COUNT + type) is set once that class's evidence type has been collected
+    atomic_int size;                        //Number of bits set, also the next free slot of order
+    int order[GHOST_COUNT * EV_COUNT];      //Bits in the order they were first set, only read once the game is over
+} SharedEvidence;
 
-//Evidence linked list node
-typedef struct EvidenceNode {
-    EvidenceType data;
-    struct EvidenceNode* next;
-} EvidenceNode;
+//Evidence left in a room, one counter per ghost class and evidence type so drops and pickups never touch the heap
+typedef struct RoomEvidence {
+    int counts[GHOST_COUNT][EV_COUNT];
+    RoomLock evidenceMutex;
+} RoomEvidence;
 
 //Hunter struct
 typedef struct Hunter{
     struct Room *curRoom;
     EvidenceType reader; //The type of evidence the hunter collects
     char hunterName[MAX_STR];
-    struct EvidenceList* sharedEvidencePointer;
+    struct SharedEvidence* sharedEvidencePointer;
     int fear;
     int boredom;
+    int id;
+    struct House* house;
+    Rng rng;
+    struct Hunter* prevInRoom;  //Links of the intrusive list of hunters in curRoom
+    struct Hunter* nextInRoom;
+    MoveStats moveStats;
 } Hunter;
 
+//Room adjacency compiled into compressed sparse row form, rooms are addressed by id
+typedef struct RoomGraph{
+    int numRooms;
+    int* offsets;           //Neighbours of room i are neighbours[offsets[i]] up to neighbours[offsets[i+1]-1]
+    int* neighbours;        //Room ids
+    struct Room** rooms;    //Room id -> Room, the Van is always room 0
+    struct Room* roomBlock; //All rooms in one allocation when built from a house file, offsets and neighbours then belong to the file
+    atomic_int* ghostCounts;        //Room id -> ghosts in the room, read without a lock
+    atomic_ullong* ghostRooms;      //Occupancy bitmaps, bit id of word id / OCCUPANCY_BITS is set while a ghost is in room id
+    atomic_ullong* hunterRooms;     //and while a hunter is
+} RoomGraph;
+
 //Room struct
 typedef struct Room{
     char roomName[MAX_STR];
-    struct RoomList connectedRooms;
-    struct EvidenceList evidenceList;
-    struct Hunter* curHunters[NUM_HUNTERS];
-    Ghost* ghost;
-    sem_t roomHunterMutex;
-    sem_t roomGhostMutex;
+    int id;
+    struct RoomGraph* graph;
+    struct RoomList connectedRooms; //Only used while the house is being built, see compileHouse
+    struct RoomEvidence evidence;
+    struct Hunter* hunterHead;  //Hunters in the room, linked through the hunters themselves
+    int hunterCount;
+    RoomLock roomHunterMutex;   //Guards hunterHead and hunterCount, moves lock two rooms in room id order
+    RoomLock roomGhostMutex;    //Held while ghosts enter or leave, so the room's ghost bit follows its count
 } Room;
 
+//Floor plan read from a house file, loaded once and shared read-only by every game built from it
+typedef struct HouseDesc{
+    int numRooms;
+    int numNeighbours;
+    int* offsets;               //Same layout as RoomGraph
+    int* neighbours;
+    unsigned int* nameOffsets;  //Room id -> offset of the room's name in names
+    char* names;                //Interned room names, each NUL terminated
+    long namesSize;
+    void* image;                //Mapping of a compiled image the arrays point into, NULL when parsed from text
+    long imageSize;
+} HouseDesc;
+
+//Parameters of a procedurally generated house
+typedef struct GenSpec{
+    GenTopology topology;
+    int rooms;
+    int degree;                     //Mean number of connections per room
+    GenDistribution distribution;   //How random rooms are picked: uniformly, or in proportion to their connections
+} GenSpec;
+
+//Start of a compiled house image. Followed by offsets[numRooms + 1], neighbours[numNeighbours],
+//nameOffsets[numRooms] and namesSize bytes of names, all native 32-bit ints so the image is used in place
+typedef struct HouseImageHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t numRooms;
+    uint32_t numNeighbours;
+    uint32_t namesSize;
+} HouseImageHeader;
+
+//Binary trace of one game, encoded in memory and appended to the trace file when the game ends
+typedef struct TraceBuffer{
+    unsigned char* data;
+    long size;
+    long capacity;
+    long lastTime;          //Time of the previous event, timestamps are stored as deltas
+    pthread_mutex_t mutex;  //Agents of a threaded game append concurrently
+} TraceBuffer;
+
+//Signal ending a game once its outcome is decided: a hunter left with sufficient evidence, or every hunter left.
+//Agents of a threaded game sleep on wake, so they stop as soon as it is raised instead of at the end of their wait
+typedef struct GameEnd{
+    atomic_int over;            //C_TRUE once the outcome is decided
+    atomic_int huntersLeft;     //Hunters still in the house
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;        //Broadcast when over is raised, waited on against CLOCK_MONOTONIC
+} GameEnd;
+
 //House struct
-typedef struct{
-    struct Hunter curHunters[NUM_HUNTERS];
-    struct RoomList rooms;
-    struct EvidenceList sharedEvidence;
+typedef struct House{
+    struct Hunter* curHunters;
+    int numHunters;
+    struct Ghost* curGhosts;
+    int numGhosts;
+    struct RoomList rooms;          //Only used while the house is being built, see compileHouse
+    struct Arena* arena;            //Every allocation of the game, released in one step by freeProgram
+    struct ArenaMark arenaMark;     //Where the arena stood before the game
+    struct RoomGraph graph;
+    struct SharedEvidence sharedEvidence;
+    struct GameEnd end;
+    long now;                       //Simulated time in microseconds, or -1 while the game runs on real threads
+    struct timespec startTime;      //Wall clock start of a threaded game
+    struct TraceBuffer* trace;      //NULL unless a binary trace is being written
+    int runId;                      //Id of the run, every random stream of the game is derived from it
+    Rng rng;                        //Stream used while the house and agents are set up
 } HouseType;
 
+//One logged event, formatted into text only when it is written out
+typedef struct LogRecord{
+    enum LogEvent event;
+    int detail;             //Evidence type, ghost type or LoggerDetails, depending on the event
+    int agentId;            //Hunter or ghost id
+    int roomId;             //-1 if the event has no room
+    char agent[MAX_STR];    //Hunter name, or the ghost's number when there are several ghosts
+    char room[MAX_STR];
+} LogRecord;
+
+//Single-producer single-consumer ring of log records, one per logging thread
+typedef struct LogRing{
+    atomic_ulong head;      //Next slot the owning thread writes
+    atomic_ulong tail;      //Next slot the flusher reads
+    atomic_ulong dropped;   //Records lost because the ring was full
+    atomic_int closed;      //Set once the owning thread has exited
+    struct LogRing* next;
+    LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+//Pending wake-up of an agent in the virtual time engine
+typedef struct WakeUp{
+    long time;          //Simulated time of the wake-up in microseconds
+    long seq;           //Order the wake-up was scheduled in, breaks ties between equal times
+    Hunter* hunter;     //Hunter waking up, or NULL if it is a ghost
+    Ghost* ghost;
+} WakeUp;
+
+//Binary min-heap of wake-ups ordered by (time, seq)
+typedef struct WakeUpQueue{
+    WakeUp* heap;
+    int size;
+    int capacity;
+    long nextSeq;
+} WakeUpQueue;
+
+//A game's wake-ups and how far it got, so the game can be played a hunters' turn at a time by a real time driver
+typedef struct Schedule{
+    WakeUpQueue queue;
+    long now;           //Simulated time of the last wake-up played
+    long due;           //Simulated time of the next hunters' turn, once playSchedule stopped before it
+    int over;           //C_TRUE once the game's outcome is decided
+} Schedule;
+
+//Hot state of every hunter of a tick engine game, one array per field so the kernel updates SOA_LANES hunters per instruction.
+//The arrays are padded to a multiple of SOA_LANES, padding lanes are never alive. Names, equipment and links stay in Hunter
+typedef struct HunterSoA{
+    int count;          //Hunters in the game
+    int padded;         //count rounded up to a multiple of SOA_LANES
+    int* room;          //Room id of each hunter
+    int* fear;
+    int* boredom;
+    int* alive;         //-1 while the hunter is in the house, 0 once it left
+    int* leaving;       //Set to -1 by the kernel for hunters leaving this tick
+    int* roomGhosts;    //Room id -> ghosts in the room, a plain copy of the graph's ghostCounts kept up to date by the engine
+} HunterSoA;
+
+//SOA_LANES ints, one per hunter, operated on as one value with GCC vector extensions
+typedef int SoaVec __attribute__((vector_size(SOA_LANES * sizeof(int))));
+
+//xoshiro256** state of one agent in every lane, word-major so each word of all the lanes is one vector
+typedef struct LaneRng{
+    uint64_t s[4][LANES];
+} LaneRng;
+
+//LANES independent games of a batch played in lock step by the lanes engine, one game per lane. Every array holds one
+//entry per lane for each agent or room, indexed [agent or room * LANES + lane], and the lanes of a game that ended are masked off
+typedef struct LaneWorld{
+    int numHunters;
+    int numGhosts;
+    int numRooms;
+    int* offsets;           //Room graph shared by every game, borrowed from a built house
+    int* neighbours;
+    int active[LANES];      //-1 while the lane is playing a game
+    int runId[LANES];
+    long start[LANES];      //Time the lane's game started, games only start on multiples of HUNTER_WAIT and GHOST_WAIT
+    long last[LANES];       //Time of the last turn taken in the lane's game
+    int huntersLeft[LANES];
+    int ghostsLeft[LANES];
+    int decided[LANES];     //-1 once a hunter left with sufficient evidence
+    long moves[LANES];
+    unsigned int found[LANES];                  //SharedEvidence.found of each game
+    int orderSize[LANES];
+    int order[(GHOST_COUNT * EV_COUNT + 1) * LANES];    //SharedEvidence.order, one spare slot so it can be written unconditionally
+    int* hunterRoom;
+    int* fear;
+    int* boredom;
+    int* hunterAlive;       //-1 while the hunter is in the house
+    LaneRng* hunterRng;
+    int* ghostRoom;
+    int* ghostBored;
+    int* ghostAlive;
+    int* ghostClass;
+    LaneRng* ghostRng;
+    int* roomHunters;
+    int* roomGhosts;
+    int* evidence;          //Indexed [((room * GHOST_COUNT + class) * EV_COUNT + type) * LANES + lane]
+} LaneWorld;
+
+//One state of a single ghost game as the exact solver sees it. Evidence counts are lumped into one bit per room and type,
+//because only the first piece of a type the hunters collect changes what they know
+typedef struct ExactState{
+    uint64_t present;       //Bit room * EV_COUNT + type: uncollected evidence of a type still worth collecting
+    int found;              //Evidence types collected so far, one bit per EvidenceType
+    int ghostClass;
+    int ghostRoom;
+    int ghostGone;          //C_TRUE once the ghost left, it still scares the hunters in its room
+    int ghostBoredom;
+    int hunterRoom[EXACT_MAX_HUNTERS];
+    int hunterFear[EXACT_MAX_HUNTERS];
+    int hunterBoredom[EXACT_MAX_HUNTERS];
+    int hunterExit[EXACT_MAX_HUNTERS];  //LOG_FEAR, LOG_BORED or LOG_EVIDENCE once the hunter left, LOG_UNKNOWN before
+} ExactState;
+
+//Probability of every state reached at one point of the game, keyed by the packed state
+typedef struct StateMap{
+    int keyBytes;
+    long count;
+    long capacity;          //States keys and probs have room for
+    long mask;              //Number of slots - 1, the number of slots is a power of two
+    long* slots;            //Index of the state in each slot, -1 when empty
+    unsigned char* keys;    //count packed states of keyBytes each
+    double* probs;
+} StateMap;
+
+//Probabilities of the outcomes of a game, in the categories a batch counts
+typedef struct ExactResult{
+    double fearWins;
+    double boredomWins;
+    double mixedWins;
+    double hunterWins;
+    double correctGuesses;
+    double incorrectGuesses;
+    double unresolved;      //Probability of the games still going when the solver gave up
+    long states;            //Transient states visited
+    long largestLayer;      //Most states reached at one point of the game
+    int turns;              //Hunter turns until every game was over
+} ExactResult;
+
+//Everything the exact solver needs while it walks the states of a house
+typedef struct ExactSolver{
+    RoomGraph* graph;
+    int numHunters;
+    StateMap* next;         //States after the turn being expanded
+    ExactResult result;
+} ExactSolver;
+
+//Command line options
+typedef struct Options{
+    int runs;           //Number of headless games to run, 0 for a single interactive game
+    unsigned int seed;  //Base seed for the random number generator
+    int seeded;         //C_TRUE if a seed was given on the command line
+    EngineType engine;  //Which engine runs the games
+    int workers;        //Worker threads running batch games, 0 for one per core
+    int hunters;        //Number of hunters in every game
+    int ghosts;         //Number of ghosts in every game
+    LogMode logMode;    //Print log lines from the agents, or queue them for a background flusher
+    char* tracePath;    //Binary trace file, NULL for none
+    char* housePath;    //House description or compiled image, NULL for the built in house
+    int generate;       //C_TRUE to play in a generated house
+    GenSpec genSpec;    //The generated house, when generate is set
+    int exact;          //C_TRUE to solve for the outcome probabilities instead of playing games
+    int live;           //Games each worker paces at once on the events engine
+} Options;
+
+//Outcome of a single finished game
+typedef struct GameResult{
+    int fearCount;      //Number of hunters that ran away in fear
+    int boredCount;     //Number of hunters that left due to boredom
+    unsigned int guess;     //Ghost classes determined from the shared evidence, one bit per GhostClass
+    unsigned int actual;    //Classes of the ghosts actually in the house
+    int numHunters;     //Number of hunters in the game
+    long length;        //Length of the game in microseconds
+    MoveStats moveStats;    //Summed over every agent of the game
+} GameResult;
+
+//Aggregate outcomes over many games
+typedef struct BatchStats{
+    int runs;
+    int fearWins;       //Games where every hunter ran away in fear
+    int boredomWins;    //Games where every hunter left due to boredom
+    int mixedWins;      //Games where the hunters left due to a mix of fear and boredom
+    int hunterWins;     //Games where the hunters found sufficient evidence
+    int correctGuesses;
+    int incorrectGuesses;
+    long totalLength;
+    long minLength;
+    long maxLength;
+    MoveStats moveStats;
+    long pacedTurns;    //Hunters' turns the timer wheel paced, only the events engine paces them in a batch
+    long lateTotal;     //Microseconds those turns started after they were due, added up
+    long lateMax;
+    long lateHist[JITTER_BUCKETS];
+} BatchStats;
+
+//Work-stealing deque of run ids (Chase-Lev). The owner pushes and pops at the bottom, thieves steal from the top
+typedef struct TaskDeque{
+    atomic_long top;
+    atomic_long bottom;
+    long capacity;
+    int* tasks;
+} TaskDeque;
+
+//Worker thread of the run farm, with its own deque and its own result accumulator
+typedef struct Worker{
+    pthread_t thread;
+    int id;
+    TaskDeque deque;
+    BatchStats stats;
+    struct Options* options;
+    struct Worker* workers;
+    int numWorkers;
+} __attribute__((aligned(64))) Worker;
+
+//Game paced by a worker's timer wheel. Games end in any order, so each one allocates from its own arena
+typedef struct LiveGame{
+    HouseType house;
+    Arena arena;
+    Schedule schedule;
+    long dueTick;               //Wheel tick of the game's next hunters' turn
+    struct LiveGame* next;      //Next game in the same wheel slot
+} LiveGame;
+
+//Hashed timer wheel of a worker. Slot t % WHEEL_SLOTS holds the games due at tick t, and t + k * WHEEL_SLOTS
+//for the games due a whole turn of the wheel later, which stay put when the slot comes round
+typedef struct TimerWheel{
+    LiveGame* slots[WHEEL_SLOTS];
+    long tick;                  //Next tick to be fired
+    struct timespec origin;     //Wall clock time of tick 0
+    int timer;                  //timerfd armed for the next slot with a game in it
+    int poll;                   //epoll instance waiting on the timer
+} TimerWheel;
+
 
 // Helper Utilies
 int randInt(int,int);        // Pseudo-random number generator function
 float randFloat(float, float);  // Pseudo-random float generator function
+void seedRandom(unsigned int);  // Set the base seed every stream is derived from
+void rngInit(Rng*, int, int);   // Seed the stream of one agent of one run
+void rngUse(Rng*);              // Make a stream the one randInt/randFloat draw from on this thread
+uint64_t rngNext(Rng*);         // Next raw 64-bit value of a stream
+uint32_t rngBelow(Rng*, uint32_t); // Uniform integer in [0, n) without float conversion
 enum GhostClass randomGhost();  // Return a randomly selected a ghost type
 void ghostToString(enum GhostClass, char*); // Convert a ghost type to a string, stored in output paremeter
 void evidenceToString(enum EvidenceType, char*); // Convert an evidence type to a string, stored in output parameter
 
 // Logging Utilities
-void l_hunterInit(char* name, enum EvidenceType equipment);
-void l_hunterMove(char* name, char* room);
-void l_hunterReview(char* name, enum LoggerDetails reviewResult);
-void l_hunterCollect(char* name, enum EvidenceType evidence, char* room);
-void l_hunterExit(char* name, enum LoggerDetails reason);
-void l_ghostInit(enum GhostClass type, char* room);
-void l_ghostMove(char* room);
-void l_ghostEvidence(enum EvidenceType evidence, char* room);
-void l_ghostExit(enum LoggerDetails reason);
+void l_hunterInit(Hunter* hunter);
+void l_hunterMove(Hunter* hunter, Room* room);
+void l_hunterReview(Hunter* hunter, enum LoggerDetails reviewResult);
+void l_hunterCollect(Hunter* hunter, enum EvidenceType evidence, Room* room);
+void l_hunterExit(Hunter* hunter, enum LoggerDetails reason);
+void l_ghostInit(Ghost* ghost);
+void l_ghostMove(Ghost* ghost, Room* room);
+void l_ghostEvidence(Ghost* ghost, enum EvidenceType evidence, Room* room);
+void l_ghostExit(Ghost* ghost, enum LoggerDetails reason);
+void l_setEnabled(int enabled);
+void l_startAsync(LogMode mode);
+void l_flush();
+void l_stopAsync();
+int formatRecord(LogRecord* rec, char* out, int size);
+void ghostName(int id, int numGhosts, char* out);
+
+// Binary trace
+int traceOpen(char* path);
+void traceClose();
+void traceBeginGame(HouseType* house, int runId, char hunterNames[][MAX_STR]);
+void traceEndGame(HouseType* house);
+void traceRecord(HouseType* house, LogRecord* rec);
+int traceEventHasDetail(enum LogEvent event);
+int traceEventHasRoom(enum LogEvent event);
+long gameTime(HouseType* house);
+void initGameEnd(GameEnd* end, int numHunters);
+void freeGameEnd(GameEnd* end);
+void endGame(HouseType* house);
+int hunterLeft(HouseType* house, Hunter* hunter);
+int gameSleep(HouseType* house, long wait);
+int gameSleepUntil(HouseType* house, struct timespec* deadline);
+void addMicros(struct timespec* time, long micros);
 
 //Forward declarations needed across functions
 void populateRooms(HouseType* house);
 void initHouse(HouseType* house);
-Room* createRoom(char* roomName);
-void connectRooms(Room* room1, Room* room2);
-void addRoom(RoomList* roomList, Room* room);
-Hunter initHunter(char* name, Room* startingRoom, EvidenceType equipment, EvidenceList* sharedEvidence);
-void initGhost(RoomList* rooms, Ghost* curGhost);
+void compileHouse(HouseType* house);
+Room* createRoom(Arena* arena, char* roomName);
+void initRoom(Room* room, char* roomName);
+void initOccupancy(RoomGraph* graph, Arena* arena);
+void ghostEntered(Room* room);
+void ghostLeft(Room* room);
+Room* nearestGhostRoom(Room* from, int* distance);
+int loadHouseFile(char* path);
+int setLoadedHouse(HouseDesc* desc, char* source);
+void buildNeighbours(HouseDesc* desc, int* edges, long numEdges);
+int parseGenSpec(char* text, GenSpec* spec);
+void generateHouse(GenSpec* spec, HouseDesc* desc);
+void unloadHouseFile();
+int buildLoadedHouse(HouseType* house);
+int parseHouseText(char* path, HouseDesc* desc);
+int mapHouseImage(char* path, HouseDesc* desc);
+int writeHouseImage(HouseDesc* desc, char* path);
+int validateHouse(HouseDesc* desc, char* path);
+void freeHouseDesc(HouseDesc* desc);
+void connectRooms(Arena* arena, Room* room1, Room* room2);
+void addRoom(Arena* arena, RoomList* roomList, Room* room);
+Hunter initHunter(HouseType* house, int id, char* name, EvidenceType equipment);
+void initGhost(HouseType* house, Ghost* curGhost, int id);
 void* runHunter(void* voidHunter);
 void* runGhost(void* curGhost);
-void deallocateRoom(RoomNode* room);
-void deallocateSharedEvidenceList(EvidenceList sharedEvidence);
+int hunterStep(Hunter* curHunter);
+int hunterAct(Hunter* curHunter);
+int ghostStep(Ghost* curGhost);
+void removeHunter(Hunter* hunter);
+void linkHunter(Room* room, Hunter* hunter);
+void unlinkHunter(Room* room, Hunter* hunter);
 GhostClass ghostGuess(int sharedEvidenceSize, EvidenceType* found);
-void addEvidence(EvidenceList* evList, EvidenceType evType);
-Room* selectConnectedRoom(Room* curRoom, sem_t* mutex);
-void getNames(char hunterNames[][MAX_STR]);
-void printEndIntro(Hunter curHunters[NUM_HUNTERS]);
-void printEvidence(EvidenceList sharedEvidence, EvidenceType found[3]);
-void printEndRemainder(GhostClass ghostDetermined, GhostClass actualType);
-void printEnd(HouseType house, GhostClass actualType);
-void freeProgram(RoomNode* head, EvidenceList sharedEvidence);
-void initProgram(HouseType* house, Ghost* ghost);
-void runThreads(HouseType* house, Ghost* ghost);
\ No newline at end of file
+GhostClass ghostByMask(unsigned int evidence);
+void dropEvidence(RoomEvidence* evidence, GhostClass ghostType, EvidenceType evType);
+int removeEvidence(Hunter* hunter);
+int isGhostInRoom(Room* curRoom);
+int isHunterInRoom(Room* curRoom);
+Room* selectConnectedRoom(Room* curRoom);
+void lockRoomPair(RoomLock* fromMutex, Room* from, RoomLock* toMutex, Room* to, MoveStats* stats);
+void unlockRoomPair(RoomLock* fromMutex, RoomLock* toMutex);
+void initRoomLock(RoomLock* lock);
+void instrInit();
+void instrBeginGame(HouseType* house);
+void instrLock(RoomLock* lock);
+int instrTryLock(RoomLock* lock);
+void instrUnlock(RoomLock* lock);
+long instrNow();
+void instrCall(InstrFunction fn, long start);
+void instrReport();
+void getNames(char hunterNames[][MAX_STR], int numHunters);
+void printEndIntro(Hunter* curHunters, int numHunters, int numGhosts);
+void printEvidence(SharedEvidence* sharedEvidence);
+int getSharedEvidence(SharedEvidence* sharedEvidence, GhostClass ghostType, EvidenceType found[EV_COUNT]);
+unsigned int identifyGhosts(SharedEvidence* sharedEvidence);
+unsigned int ghostClasses(HouseType* house);
+void printEndRemainder(unsigned int determined, unsigned int actual);
+void printEnd(HouseType* house);
+void freeProgram(HouseType* house);
+void initProgram(HouseType* house, int numHunters, int numGhosts);
+void initGame(HouseType* house, char hunterNames[][MAX_STR], int numHunters, int numGhosts, int runId);
+void runThreads(HouseType* house);
+long runVirtual(HouseType* house);
+long runEvents(HouseType* house);
+void initSchedule(Schedule* schedule, HouseType* house);
+int playSchedule(Schedule* schedule, HouseType* house, long until);
+void runWheel(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed);
+long runTick(HouseType* house);
+void initHunterSoA(HunterSoA* soa, HouseType* house);
+int tickKernel(HunterSoA* soa);
+long runEngine(HouseType* house, EngineType engine);
+int parseOptions(int argc, char* argv[], Options* options);
+void evaluateGame(HouseType* house, GameResult* result);
+void runBatch(Options* options);
+void recordResult(BatchStats* stats, GameResult* result);
+long lateBound(BatchStats* stats, double fraction);
+void printBatchStats(BatchStats* stats, Options* options, double seconds);
+void runGame(Options* options, int runId, char hunterNames[][MAX_STR], GameResult* result);
+void mergeStats(BatchStats* total, BatchStats* part);
+void runFarm(Options* options, BatchStats* stats);
+int findTask(Worker* worker, unsigned int* victimSeed, int* task);
+void runLanes(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed);
+void initLaneWorld(LaneWorld* world, RoomGraph* graph, int numHunters, int numGhosts);
+void freeLaneWorld(LaneWorld* world);
+void startLaneGame(LaneWorld* world, int lane, int runId, long now);
+void finishLaneGame(LaneWorld* world, int lane, GameResult* result);
+void laneHunterTurn(LaneWorld* world, int hunter);
+void laneGhostTurn(LaneWorld* world, int ghost);
+int runExact(Options* options);
+int solveExact(RoomGraph* graph, int numHunters, ExactResult* result);
+void printExact(ExactResult* result, Options* options, BatchStats* stats);
+void* arenaAlloc(Arena* arena, size_t bytes);
+ArenaMark arenaMark(Arena* arena);
+void arenaRelease(Arena* arena, ArenaMark mark);
+void arenaFree(Arena* arena);
+Arena* gameArena();
+void arenaUse(Arena* arena);
+void initStateMap(StateMap* map, int keyBytes);
+void clearStateMap(StateMap* map);
+void freeStateMap(StateMap* map);
+void addState(StateMap* map, unsigned char* key, double prob);
+void initDeque(TaskDeque* deque, long capacity);
+void pushTask(TaskDeque* deque, int task);
+int popTask(TaskDeque* deque, int* task);
+int stealTask(TaskDeque* deque, int* task);
\ No newline at end of file
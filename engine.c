@@ -0,0 +1,366 @@
+#include "defs.h"
+
+//Forward declarations
+void pushWakeUp(WakeUpQueue* queue, long time, Hunter* hunter, Ghost* ghost);
+WakeUp popWakeUp(WakeUpQueue* queue);
+int wakeUpBefore(WakeUp* a, WakeUp* b);
+long runSchedule(HouseType* house, int paced);
+
+/*
+    Function: runEngine(HouseType* house, EngineType engine)
+    Purpose:  Runs one initialized game to completion on the requested engine.
+    Params:
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+        Input: EngineType engine - stores which engine runs the game.
+    Return: long - returns the length of the game in microseconds, wall clock for threads and simulated for the other engines.
+*/
+long runEngine(HouseType* house, EngineType engine){
+    if(engine == ENGINE_VIRTUAL){
+        return runVirtual(house);
+    }
+    if(engine == ENGINE_EVENTS){
+        return runEvents(house);
+    }
+    //A single game cannot fill the lanes, it plays the same game on the tick engine
+    if(engine == ENGINE_TICK || engine == ENGINE_LANES){
+        return runTick(house);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &(house->startTime));
+    house->now = -1;
+    runThreads(house);
+    return gameTime(house);
+}
+
+/*
+    Function: gameTime(HouseType* house)
+    Purpose:  Reads the game's clock, simulated for the virtual engine and wall clock for threads.
+    Params:
+        Input: HouseType* house - points to the house of the game.
+    Return: long - returns the time since the game started in microseconds.
+*/
+long gameTime(HouseType* house){
+    if(house->now >= 0){
+        return house->now;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - house->startTime.tv_sec) * 1000000L + (now.tv_nsec - house->startTime.tv_nsec) / 1000;
+}
+
+/*
+    Function: initGameEnd(GameEnd* end, int numHunters)
+    Purpose:  Sets up the termination signal of a game that has not been decided yet.
+    Params:
+        Output: GameEnd* end - points to the signal being set up.
+        Input: int numHunters - stores the number of hunters in the house.
+    Return: void
+*/
+void initGameEnd(GameEnd* end, int numHunters){
+    atomic_init(&(end->over), C_FALSE);
+    atomic_init(&(end->huntersLeft), numHunters);
+    pthread_mutex_init(&(end->mutex), NULL);
+    //Waits are against the monotonic clock, like the game's own clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(end->wake), &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/*
+    Function: freeGameEnd(GameEnd* end)
+    Purpose:  Destroys the termination signal of a game no agent is waiting on any more.
+    Params:
+        Input/Output: GameEnd* end - points to the signal.
+    Return: void
+*/
+void freeGameEnd(GameEnd* end){
+    pthread_cond_destroy(&(end->wake));
+    pthread_mutex_destroy(&(end->mutex));
+}
+
+/*
+    Function: endGame(HouseType* house)
+    Purpose:  Marks the game's outcome as decided and wakes every agent sleeping in gameSleep, so they leave straight away.
+    Params:
+        Input/Output: HouseType* house - points to the house of the game.
+    Return: void
+*/
+void endGame(HouseType* house){
+    GameEnd* end = &(house->end);
+    //Raised under the mutex, so an agent between its check and its wait cannot miss the broadcast
+    pthread_mutex_lock(&(end->mutex));
+    atomic_store_explicit(&(end->over), C_TRUE, memory_order_release);
+    pthread_cond_broadcast(&(end->wake));
+    pthread_mutex_unlock(&(end->mutex));
+}
+
+/*
+    Function: hunterLeft(HouseType* house, Hunter* hunter)
+    Purpose:  Records that a hunter left the house, and ends the game if that decides it. A hunter leaving with sufficient
+              evidence wins the game for the hunters, and once the last hunter is gone nothing the ghosts do changes the result.
+    Params:
+        Input/Output: HouseType* house - points to the house of the game.
+        Input: Hunter* hunter - points to the hunter that left, neither afraid nor bored if it left with sufficient evidence.
+    Return: int - returns C_TRUE if the game is over, or C_FALSE otherwise
+*/
+int hunterLeft(HouseType* house, Hunter* hunter){
+    int left = atomic_fetch_sub_explicit(&(house->end.huntersLeft), 1, memory_order_acq_rel) - 1;
+    int evidence = (hunter->fear < FEAR_MAX && hunter->boredom < BOREDOM_MAX) ? C_TRUE : C_FALSE;
+    if(left == 0 || evidence == C_TRUE){
+        endGame(house);
+        return C_TRUE;
+    }
+    return C_FALSE;
+}
+
+/*
+    Function: gameSleep(HouseType* house, long wait)
+    Purpose:  Sleeps an agent of a threaded game for its wait, waking early if the game ends in the meantime.
+    Params:
+        Input/Output: HouseType* house - points to the house of the game.
+        Input: long wait - stores how long the agent waits in microseconds.
+    Return: int - returns C_TRUE if the game is over, or C_FALSE if the agent slept its whole wait and can take its turn
+*/
+int gameSleep(HouseType* house, long wait){
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    addMicros(&deadline, wait);
+    return gameSleepUntil(house, &deadline);
+}
+
+/*
+    Function: gameSleepUntil(HouseType* house, struct timespec* deadline)
+    Purpose:  Sleeps until a time on the monotonic clock, waking early if the game ends in the meantime.
+    Params:
+        Input/Output: HouseType* house - points to the house of the game.
+        Input: struct timespec* deadline - stores the time to wake up at, nothing is waited for if it already passed.
+    Return: int - returns C_TRUE if the game is over, or C_FALSE otherwise
+*/
+int gameSleepUntil(HouseType* house, struct timespec* deadline){
+    GameEnd* end = &(house->end);
+    pthread_mutex_lock(&(end->mutex));
+    //Spurious wake-ups go back to sleep until the deadline
+    while(atomic_load_explicit(&(end->over), memory_order_acquire) == C_FALSE){
+        if(pthread_cond_timedwait(&(end->wake), &(end->mutex), deadline) != 0){
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(end->mutex));
+    return atomic_load_explicit(&(end->over), memory_order_acquire);
+}
+
+/*
+    Function: addMicros(struct timespec* time, long micros)
+    Purpose:  Moves a time forward by a number of microseconds.
+    Params:
+        Input/Output: struct timespec* time - points to the time.
+        Input: long micros - stores the number of microseconds, 0 or more.
+    Return: void
+*/
+void addMicros(struct timespec* time, long micros){
+    time->tv_sec += micros / 1000000;
+    time->tv_nsec += (micros % 1000000) * 1000;
+    if(time->tv_nsec >= 1000000000){
+        time->tv_sec++;
+        time->tv_nsec -= 1000000000;
+    }
+}
+
+/*
+    Function: runVirtual(HouseType* house)
+    Purpose:  Runs a whole game on the calling thread against a simulated clock.
+              Every agent keeps the cadence it has in runHunter/runGhost (HUNTER_WAIT and GHOST_WAIT), but the waits
+              become jumps of the simulated clock to the next queued wake-up instead of calls to usleep.
+    Params:
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+    Return: long - returns the simulated time in microseconds at which the game's outcome was decided.
+*/
+long runVirtual(HouseType* house){
+    return runSchedule(house, C_FALSE);
+}
+
+/*
+    Function: runEvents(HouseType* house)
+    Purpose:  Runs a whole game on the calling thread in real time. The game is the one runVirtual plays, but before the hunters
+              take a turn the thread blocks on the game's condition variable until that turn is due on the wall clock.
+              The hunters' turns are the only ones that need the clock: a ghost's turn only depends on whether a hunter is in
+              its room, which changes on the hunters' turns alone, so the ghost turns due before the next hunters' turn are
+              played straight after the last one. A game wakes its thread once per HUNTER_WAIT, where runThreads wakes one
+              thread per agent every time that agent's wait runs out.
+    Params:
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+    Return: long - returns the simulated time in microseconds at which the game's outcome was decided, which is also how
+                   long it took on the wall clock.
+*/
+long runEvents(HouseType* house){
+    clock_gettime(CLOCK_MONOTONIC, &(house->startTime));
+    return runSchedule(house, C_TRUE);
+}
+
+/*
+    Function: runSchedule(HouseType* house, int paced)
+    Purpose:  Plays the queue of agent wake-ups of a game in order of their simulated time, for runVirtual and runEvents.
+    Params:
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+        Input: int paced - stores C_TRUE to wait for each hunters' turn on the wall clock, counted from house->startTime.
+    Return: long - returns the simulated time in microseconds at which the game's outcome was decided.
+*/
+long runSchedule(HouseType* house, int paced){
+    Schedule schedule;
+    initSchedule(&schedule, house);
+    long until = (paced == C_TRUE) ? 0 : LONG_MAX;
+    while(playSchedule(&schedule, house, until) == C_TRUE){
+        struct timespec due = house->startTime;
+        addMicros(&due, schedule.due);
+        gameSleepUntil(house, &due);
+        until = schedule.due;
+    }
+    return schedule.now;
+}
+
+/*
+    Function: initSchedule(Schedule* schedule, HouseType* house)
+    Purpose:  Queues the first wake-up of every agent of an initialized game.
+    Params:
+        Output: Schedule* schedule - points to the schedule being set up, its queue comes from the game's arena.
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+    Return: void
+*/
+void initSchedule(Schedule* schedule, HouseType* house){
+    WakeUpQueue* queue = &(schedule->queue);
+    queue->capacity = house->numHunters + house->numGhosts;
+    queue->heap = (WakeUp*) arenaAlloc(house->arena, sizeof(WakeUp) * queue->capacity);
+    queue->size = 0;
+    queue->nextSeq = 0;
+    //Same creation order as runThreads, each agent sleeps once before its first turn
+    for(int i = 0; i < house->numGhosts; i++){
+        pushWakeUp(queue, GHOST_WAIT, NULL, &(house->curGhosts[i]));
+    }
+    for(int i = 0; i < house->numHunters; i++){
+        pushWakeUp(queue, HUNTER_WAIT, &(house->curHunters[i]), NULL);
+    }
+    schedule->now = 0;
+    schedule->due = 0;
+    schedule->over = C_FALSE;
+}
+
+/*
+    Function: playSchedule(Schedule* schedule, HouseType* house, long until)
+    Purpose:  Plays a game's wake-ups in order until the next one is a hunters' turn after until, or the game is over.
+              The ghost turns are played whenever they come up: a ghost's turn only depends on whether a hunter is in its room,
+              which changes on the hunters' turns alone, so only the hunters' turns have to wait for a real time clock.
+              The game stops once its outcome is decided, after the rest of the hunters due at that time took their turn.
+    Params:
+        Input/Output: Schedule* schedule - points to the game's schedule.
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+        Input: long until - stores the simulated time in microseconds up to which hunters may take their turn.
+    Return: int - returns C_TRUE if the game goes on with a hunters' turn at schedule->due, or C_FALSE once it is over
+*/
+int playSchedule(Schedule* schedule, HouseType* house, long until){
+    WakeUpQueue* queue = &(schedule->queue);
+    int more = C_FALSE;
+    while(queue->size > 0){
+        WakeUp* head = &(queue->heap[0]);
+        //Hunters come before ghosts at the same time, so the first ghost or later wake-up ends a decided game
+        if(schedule->over == C_TRUE && (head->time > schedule->now || head->hunter == NULL)){
+            break;
+        }
+        if(head->hunter != NULL && head->time > until){
+            schedule->due = head->time;
+            more = C_TRUE;
+            break;
+        }
+        WakeUp next = popWakeUp(queue);
+        schedule->now = next.time;
+        house->now = next.time;
+        //Each agent draws from its own stream, as it would on its own thread
+        rngUse((next.hunter != NULL) ? &(next.hunter->rng) : &(next.ghost->rng));
+        if(next.hunter != NULL){
+            if(hunterStep(next.hunter) == C_TRUE){
+                removeHunter(next.hunter);
+                schedule->over |= hunterLeft(house, next.hunter);
+            }
+            else{
+                pushWakeUp(queue, next.time + HUNTER_WAIT, next.hunter, NULL);
+            }
+        }
+        else if(ghostStep(next.ghost) == C_FALSE){
+            pushWakeUp(queue, next.time + GHOST_WAIT, NULL, next.ghost);
+        }
+    }
+    rngUse(NULL);
+    return more;
+}
+
+/*
+    Function: wakeUpBefore(WakeUp* a, WakeUp* b)
+    Purpose:  Orders wake-ups by time, and by the order they were scheduled in when the times are equal.
+    Params:
+        Input: WakeUp* a - points to the first wake-up.
+        Input: WakeUp* b - points to the second wake-up.
+    Return: int - returns C_TRUE if a has to run before b, or C_FALSE otherwise
+*/
+int wakeUpBefore(WakeUp* a, WakeUp* b){
+    if(a->time != b->time){
+        return a->time < b->time;
+    }
+    return a->seq < b->seq;
+}
+
+/*
+    Function: pushWakeUp(WakeUpQueue* queue, long time, Hunter* hunter, Ghost* ghost)
+    Purpose:  Schedules an agent to wake up at the given simulated time.
+    Params:
+        Input/Output: WakeUpQueue* queue - points to the queue the wake-up is added to.
+        Input: long time - stores the simulated time of the wake-up.
+        Input: Hunter* hunter - points to the hunter waking up, or NULL for a ghost.
+        Input: Ghost* ghost - points to the ghost waking up, or NULL for a hunter.
+    Return: void
+*/
+void pushWakeUp(WakeUpQueue* queue, long time, Hunter* hunter, Ghost* ghost){
+    int i = queue->size++;
+    WakeUp new = {time, queue->nextSeq++, hunter, ghost};
+    //Sift the new wake-up up towards the root
+    while(i > 0){
+        int parent = (i - 1) / 2;
+        if(wakeUpBefore(&new, &(queue->heap[parent])) == C_FALSE){
+            break;
+        }
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = new;
+}
+
+/*
+    Function: popWakeUp(WakeUpQueue* queue)
+    Purpose:  Removes the earliest wake-up from the queue.
+    Params:
+        Input/Output: WakeUpQueue* queue - points to a non-empty queue.
+    Return: WakeUp - returns the earliest wake-up.
+*/
+WakeUp popWakeUp(WakeUpQueue* queue){
+    WakeUp top = queue->heap[0];
+    WakeUp last = queue->heap[--queue->size];
+    int i = 0;
+    //Sift the last wake-up down from the root
+    while(C_TRUE){
+        int child = 2 * i + 1;
+        if(child >= queue->size){
+            break;
+        }
+        if(child + 1 < queue->size && wakeUpBefore(&(queue->heap[child + 1]), &(queue->heap[child])) == C_TRUE){
+            child++;
+        }
+        if(wakeUpBefore(&(queue->heap[child]), &last) == C_FALSE){
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    if(queue->size > 0){
+        queue->heap[i] = last;
+    }
+    return top;
+}
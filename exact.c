@@ -0,0 +1,600 @@
+#include "defs.h"
+
+#define EXACT_KEY_BASE   14     //present, found, ghostClass, ghostRoom, ghostGone and ghostBoredom
+#define EXACT_KEY_HUNTER 6      //Room, exit, fear and boredom of one hunter
+
+void expandGhostTurn(ExactSolver* solver, ExactState* state, double prob);
+void expandHunterTurn(ExactSolver* solver, ExactState* state, int hunter, double prob);
+void recordState(ExactSolver* solver, ExactState* state, double prob);
+void recordOutcome(ExactResult* result, ExactState* state, int numHunters, double prob);
+void packState(ExactState* state, int numHunters, unsigned char* key);
+void unpackState(unsigned char* key, int numHunters, ExactState* state);
+int exactKeyBytes(int numHunters);
+long ghostTurnsBefore(long hunterTurn);
+uint64_t hashKey(unsigned char* key, int bytes);
+void growStateMap(StateMap* map);
+void printExactLine(char* label, double prob, int count, BatchStats* stats);
+
+/*
+    Function: runExact(Options* options)
+    Purpose:  Solves for the exact outcome probabilities of a single ghost game in the chosen house and prints them.
+              With --runs the same games are also played on the chosen engine, and every sampled frequency is printed
+              next to its exact probability, so the solver is the ground truth the engines are checked against.
+    Params:
+        Input: Options* options - stores the house, the number of hunters and ghosts, and the batch to compare with.
+    Return: int - returns C_TRUE if the outcome was printed, or C_FALSE if the game is too large to solve.
+*/
+int runExact(Options* options){
+    if(options->ghosts != 1){
+        fprintf(stderr, "--exact solves games with a single ghost\n");
+        return C_FALSE;
+    }
+    if(options->hunters > EXACT_MAX_HUNTERS){
+        fprintf(stderr, "--exact solves games with at most %d hunters\n", EXACT_MAX_HUNTERS);
+        return C_FALSE;
+    }
+    l_setEnabled(C_FALSE);
+    char hunterNames[EXACT_MAX_HUNTERS][MAX_STR];
+    for(int i = 0; i < options->hunters; i++){
+        sprintf(hunterNames[i], "Hunter %d", i + 1);
+    }
+    //A game is built once for its floor plan, the solver only walks its room graph
+    HouseType house;
+    initGame(&house, hunterNames, options->hunters, options->ghosts, -1);
+    if(house.graph.numRooms > EXACT_MAX_ROOMS){
+        fprintf(stderr, "--exact solves houses with at most %d rooms, this one has %d\n", EXACT_MAX_ROOMS, house.graph.numRooms);
+        freeProgram(&house);
+        return C_FALSE;
+    }
+    ExactResult result;
+    int solved = solveExact(&(house.graph), options->hunters, &result);
+    freeProgram(&house);
+    //A partial solution is no ground truth, so there is no point in playing the batch
+    if(options->runs > 0 && solved == C_TRUE){
+        BatchStats stats;
+        runFarm(options, &stats);
+        printExact(&result, options, &stats);
+    }
+    else{
+        printExact(&result, options, NULL);
+    }
+    return solved;
+}
+
+/*
+    Function: solveExact(RoomGraph* graph, int numHunters, ExactResult* result)
+    Purpose:  Computes the probability of every outcome of a single ghost game with an absorbing Markov chain. A state is what
+              the rules of the game read: the rooms, fear and boredom of the agents, and which evidence is lying where and
+              which has been found. The count of a piece of evidence is lumped into one bit, since collecting any piece of
+              a type found before changes nothing, and evidence of a type nobody left in the house reads is dropped.
+              Every hunter turn raises the fear or the boredom of every hunter still in the house, so no state repeats and
+              the chain is a DAG ordered by time: the absorption probabilities are found exactly by pushing the probability
+              of every state forward one turn at a time, in the order the engines play the turns, until every game is over.
+    Params:
+        Input: RoomGraph* graph - points to the rooms of the house, the Van is room 0.
+        Input: int numHunters - stores the number of hunters, at most EXACT_MAX_HUNTERS.
+        Output: ExactResult* result - points to the outcome probabilities.
+    Return: int - returns C_TRUE if every game was solved, or C_FALSE if more than EXACT_MAX_STATES states were reached at
+                  once, in which case the probability of the games still going is in unresolved.
+*/
+int solveExact(RoomGraph* graph, int numHunters, ExactResult* result){
+    ExactSolver solver;
+    StateMap maps[2];
+    int keyBytes = exactKeyBytes(numHunters);
+    initStateMap(&maps[0], keyBytes);
+    initStateMap(&maps[1], keyBytes);
+    memset(&solver, 0, sizeof(ExactSolver));
+    solver.graph = graph;
+    solver.numHunters = numHunters;
+    solver.next = &maps[0];
+    //Every class and every room but the Van are equally likely for the ghost, the hunters start in the Van
+    ExactState start;
+    memset(&start, 0, sizeof(ExactState));
+    for(int i = 0; i < numHunters; i++){
+        start.hunterExit[i] = LOG_UNKNOWN;
+    }
+    for(int ghostClass = 0; ghostClass < GHOST_COUNT; ghostClass++){
+        for(int room = 1; room < graph->numRooms; room++){
+            start.ghostClass = ghostClass;
+            start.ghostRoom = room;
+            recordState(&solver, &start, 1.0 / (GHOST_COUNT * (graph->numRooms - 1)));
+        }
+    }
+    int solved = C_TRUE;
+    long turn;
+    for(turn = 1; solver.next->count > 0 && solved == C_TRUE; turn++){
+        //The ghost turns due before this hunter turn, then the hunters one by one
+        long ghostTurns = ghostTurnsBefore(turn) - ghostTurnsBefore(turn - 1);
+        for(long step = 0; step < ghostTurns + numHunters; step++){
+            StateMap* cur = solver.next;
+            solver.next = (cur == &maps[0]) ? &maps[1] : &maps[0];
+            clearStateMap(solver.next);
+            ExactState state;
+            for(long i = 0; i < cur->count; i++){
+                unpackState(cur->keys + i * keyBytes, numHunters, &state);
+                if(step < ghostTurns){
+                    expandGhostTurn(&solver, &state, cur->probs[i]);
+                }
+                else{
+                    expandHunterTurn(&solver, &state, step - ghostTurns, cur->probs[i]);
+                }
+            }
+            solver.result.states += solver.next->count;
+            if(solver.next->count > solver.result.largestLayer){
+                solver.result.largestLayer = solver.next->count;
+            }
+            if(solver.next->count > EXACT_MAX_STATES){
+                for(long i = 0; i < solver.next->count; i++){
+                    solver.result.unresolved += solver.next->probs[i];
+                }
+                solved = C_FALSE;
+                break;
+            }
+        }
+    }
+    solver.result.turns = turn - 1;
+    *result = solver.result;
+    freeStateMap(&maps[0]);
+    freeStateMap(&maps[1]);
+    return solved;
+}
+
+/*
+    Function: exactKeyBytes(int numHunters)
+    Purpose:  Gives the size of a packed state, rounded up to whole 64-bit words so hashKey can read it a word at a time.
+    Params:
+        Input: int numHunters - stores the number of hunters.
+    Return: int - returns the size of a packed state in bytes.
+*/
+int exactKeyBytes(int numHunters){
+    int bytes = EXACT_KEY_BASE + numHunters * EXACT_KEY_HUNTER;
+    return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+/*
+    Function: ghostTurnsBefore(long hunterTurn)
+    Purpose:  Counts the ghost turns played before a hunter turn. Ghosts play every GHOST_WAIT and hunters every HUNTER_WAIT,
+              and the hunters go first on ties as on the virtual engine.
+    Params:
+        Input: long hunterTurn - stores the number of the hunter turn, the first is 1.
+    Return: long - returns the number of ghost turns at a time before hunterTurn * HUNTER_WAIT.
+*/
+long ghostTurnsBefore(long hunterTurn){
+    if(hunterTurn <= 0){
+        return 0;
+    }
+    return (hunterTurn * HUNTER_WAIT - 1) / GHOST_WAIT;
+}
+
+/*
+    Function: expandGhostTurn(ExactSolver* solver, ExactState* state, double prob)
+    Purpose:  Adds every state a ghost turn leads to from one state to the next layer, following ghostStep.
+    Params:
+        Input/Output: ExactSolver* solver - points to the solver, the states are added to its next layer.
+        Input: ExactState* state - points to the state before the turn.
+        Input: double prob - stores the probability of the state.
+    Return: void
+*/
+void expandGhostTurn(ExactSolver* solver, ExactState* state, double prob){
+    if(state->ghostGone == C_TRUE){
+        recordState(solver, state, prob);
+        return;
+    }
+    int hunterHere = C_FALSE;
+    for(int i = 0; i < solver->numHunters; i++){
+        if(state->hunterExit[i] == LOG_UNKNOWN && state->hunterRoom[i] == state->ghostRoom){
+            hunterHere = C_TRUE;
+        }
+    }
+    //isGhostLeaving: a hunter keeps the ghost from moving or getting bored
+    ExactState next = *state;
+    int choices = 2;
+    if(hunterHere == C_TRUE){
+        next.ghostBoredom = 0;
+    }
+    else{
+        next.ghostBoredom++;
+        choices = 3;
+        if(next.ghostBoredom == BOREDOM_MAX){
+            next.ghostGone = C_TRUE;
+            recordState(solver, &next, prob);
+            return;
+        }
+    }
+    double share = prob / choices;
+    //Leave evidence, each of the types the class leaves is equally likely
+    for(int i = 0; i < DESIRED_EVIDENCE_COUNT; i++){
+        ExactState dropped = next;
+        dropped.present |= (uint64_t) 1 << (state->ghostRoom * EV_COUNT + ghostEvidence[state->ghostClass][i]);
+        recordState(solver, &dropped, share / DESIRED_EVIDENCE_COUNT);
+    }
+    //Do nothing
+    recordState(solver, &next, share);
+    //Move
+    if(choices == 3){
+        RoomGraph* graph = solver->graph;
+        int first = graph->offsets[state->ghostRoom];
+        int degree = graph->offsets[state->ghostRoom + 1] - first;
+        for(int i = 0; i < degree; i++){
+            ExactState moved = next;
+            moved.ghostRoom = graph->neighbours[first + i];
+            recordState(solver, &moved, share / degree);
+        }
+    }
+}
+
+/*
+    Function: expandHunterTurn(ExactSolver* solver, ExactState* state, int hunter, double prob)
+    Purpose:  Adds every state one hunter's turn leads to from one state to the next layer, following hunterStep.
+    Params:
+        Input/Output: ExactSolver* solver - points to the solver, the states are added to its next layer.
+        Input: ExactState* state - points to the state before the turn.
+        Input: int hunter - stores the index of the hunter taking its turn.
+        Input: double prob - stores the probability of the state.
+    Return: void
+*/
+void expandHunterTurn(ExactSolver* solver, ExactState* state, int hunter, double prob){
+    if(state->hunterExit[hunter] != LOG_UNKNOWN){
+        recordState(solver, state, prob);
+        return;
+    }
+    //isHunterleaving, a ghost that left still counts in its room
+    ExactState next = *state;
+    int room = state->hunterRoom[hunter];
+    if(state->ghostRoom == room){
+        next.hunterFear[hunter] += FEAR_INCREMENT;
+        next.hunterBoredom[hunter] = 0;
+        if(next.hunterFear[hunter] >= FEAR_MAX){
+            next.hunterExit[hunter] = LOG_FEAR;
+            recordState(solver, &next, prob);
+            return;
+        }
+    }
+    else{
+        next.hunterBoredom[hunter]++;
+        if(next.hunterBoredom[hunter] == BOREDOM_MAX){
+            next.hunterExit[hunter] = LOG_BORED;
+            recordState(solver, &next, prob);
+            return;
+        }
+    }
+    double share = prob / 3;
+    //Collect evidence, the reader of hunter i is i % EV_COUNT as in initProgram
+    int reader = hunter % EV_COUNT;
+    ExactState collected = next;
+    if((collected.present & ((uint64_t) 1 << (room * EV_COUNT + reader))) != 0){
+        collected.found |= 1 << reader;
+    }
+    recordState(solver, &collected, share);
+    //Move
+    RoomGraph* graph = solver->graph;
+    int first = graph->offsets[room];
+    int degree = graph->offsets[room + 1] - first;
+    for(int i = 0; i < degree; i++){
+        ExactState moved = next;
+        moved.hunterRoom[hunter] = graph->neighbours[first + i];
+        recordState(solver, &moved, share / degree);
+    }
+    //Review evidence, sufficient once the types found identify the ghost
+    ExactState reviewed = next;
+    if(ghostByMask(reviewed.found) != GH_UNKNOWN){
+        reviewed.hunterExit[hunter] = LOG_EVIDENCE;
+    }
+    recordState(solver, &reviewed, share);
+}
+
+/*
+    Function: recordState(ExactSolver* solver, ExactState* state, double prob)
+    Purpose:  Adds the probability of a state to the next layer, or to the outcome once every hunter has left, since
+              nothing the ghost does afterwards changes the result.
+    Params:
+        Input/Output: ExactSolver* solver - points to the solver.
+        Input: ExactState* state - points to the state.
+        Input: double prob - stores the probability being added.
+    Return: void
+*/
+void recordState(ExactSolver* solver, ExactState* state, double prob){
+    int inHouse = C_FALSE;
+    for(int i = 0; i < solver->numHunters; i++){
+        if(state->hunterExit[i] == LOG_UNKNOWN){
+            inHouse = C_TRUE;
+        }
+    }
+    if(inHouse == C_FALSE){
+        recordOutcome(&(solver->result), state, solver->numHunters, prob);
+        return;
+    }
+    uint64_t key[(EXACT_KEY_BASE + EXACT_MAX_HUNTERS * EXACT_KEY_HUNTER + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    packState(state, solver->numHunters, (unsigned char*) key);
+    addState(solver->next, (unsigned char*) key, prob);
+}
+
+/*
+    Function: recordOutcome(ExactResult* result, ExactState* state, int numHunters, double prob)
+    Purpose:  Adds the probability of a finished game to its outcome, with the rules recordResult uses.
+    Params:
+        Input/Output: ExactResult* result - points to the outcome probabilities.
+        Input: ExactState* state - points to the state every hunter has left in.
+        Input: int numHunters - stores the number of hunters.
+        Input: double prob - stores the probability being added.
+    Return: void
+*/
+void recordOutcome(ExactResult* result, ExactState* state, int numHunters, double prob){
+    int fearCount = 0;
+    int boredCount = 0;
+    for(int i = 0; i < numHunters; i++){
+        if(state->hunterExit[i] == LOG_FEAR){
+            fearCount++;
+        }
+        else if(state->hunterExit[i] == LOG_BORED){
+            boredCount++;
+        }
+    }
+    if(fearCount >= numHunters){
+        result->fearWins += prob;
+    }
+    else if(boredCount >= numHunters){
+        result->boredomWins += prob;
+    }
+    else if(fearCount + boredCount >= numHunters){
+        result->mixedWins += prob;
+    }
+    else{
+        result->hunterWins += prob;
+    }
+    //The types found name the ghost's class once all of them were found, and nothing before that
+    if(ghostByMask(state->found) != GH_UNKNOWN){
+        result->correctGuesses += prob;
+    }
+    else{
+        result->incorrectGuesses += prob;
+    }
+}
+
+/*
+    Function: packState(ExactState* state, int numHunters, unsigned char* key)
+    Purpose:  Packs a state into the bytes it is keyed by. Whatever can no longer change the outcome is cleared first, so
+              states that only differ there are merged: the rooms, fear and boredom of hunters that left, the boredom of
+              a ghost that left, and evidence of a type already found, never left by the ghost, or read by nobody left.
+    Params:
+        Input: ExactState* state - points to the state.
+        Input: int numHunters - stores the number of hunters.
+        Output: unsigned char* key - stores exactKeyBytes(numHunters) bytes.
+    Return: void
+*/
+void packState(ExactState* state, int numHunters, unsigned char* key){
+    int wanted = 0;
+    for(int i = 0; i < numHunters; i++){
+        if(state->hunterExit[i] == LOG_UNKNOWN){
+            wanted |= 1 << (i % EV_COUNT);
+        }
+    }
+    wanted &= ~state->found & ghostEvidenceMask[state->ghostClass];
+    //wanted repeated in the EV_COUNT bits of every room
+    uint64_t present = state->present & (wanted * (~(uint64_t) 0 / ((1 << EV_COUNT) - 1)));
+    uint16_t ghostBoredom = (state->ghostGone == C_TRUE) ? 0 : state->ghostBoredom;
+    memset(key, 0, exactKeyBytes(numHunters));
+    memcpy(key, &present, sizeof(uint64_t));
+    key[8] = state->found;
+    key[9] = state->ghostClass;
+    key[10] = state->ghostRoom;
+    key[11] = state->ghostGone;
+    memcpy(key + 12, &ghostBoredom, sizeof(uint16_t));
+    for(int i = 0; i < numHunters; i++){
+        unsigned char* hunter = key + EXACT_KEY_BASE + i * EXACT_KEY_HUNTER;
+        int inHouse = (state->hunterExit[i] == LOG_UNKNOWN);
+        uint16_t fear = inHouse ? state->hunterFear[i] : 0;
+        uint16_t boredom = inHouse ? state->hunterBoredom[i] : 0;
+        hunter[0] = inHouse ? state->hunterRoom[i] : 0;
+        hunter[1] = state->hunterExit[i];
+        memcpy(hunter + 2, &fear, sizeof(uint16_t));
+        memcpy(hunter + 4, &boredom, sizeof(uint16_t));
+    }
+}
+
+/*
+    Function: unpackState(unsigned char* key, int numHunters, ExactState* state)
+    Purpose:  Unpacks the bytes written by packState.
+    Params:
+        Input: unsigned char* key - stores the packed state.
+        Input: int numHunters - stores the number of hunters.
+        Output: ExactState* state - points to the state.
+    Return: void
+*/
+void unpackState(unsigned char* key, int numHunters, ExactState* state){
+    uint16_t ghostBoredom;
+    memcpy(&(state->present), key, sizeof(uint64_t));
+    state->found = key[8];
+    state->ghostClass = key[9];
+    state->ghostRoom = key[10];
+    state->ghostGone = key[11];
+    memcpy(&ghostBoredom, key + 12, sizeof(uint16_t));
+    state->ghostBoredom = ghostBoredom;
+    for(int i = 0; i < numHunters; i++){
+        unsigned char* hunter = key + EXACT_KEY_BASE + i * EXACT_KEY_HUNTER;
+        uint16_t fear, boredom;
+        memcpy(&fear, hunter + 2, sizeof(uint16_t));
+        memcpy(&boredom, hunter + 4, sizeof(uint16_t));
+        state->hunterRoom[i] = hunter[0];
+        state->hunterExit[i] = hunter[1];
+        state->hunterFear[i] = fear;
+        state->hunterBoredom[i] = boredom;
+    }
+}
+
+/*
+    Function: initStateMap(StateMap* map, int keyBytes)
+    Purpose:  Initializes an empty map of packed states to probabilities.
+    Params:
+        Output: StateMap* map - points to the map.
+        Input: int keyBytes - stores the size of a packed state.
+    Return: void
+*/
+void initStateMap(StateMap* map, int keyBytes){
+    map->keyBytes = keyBytes;
+    map->count = 0;
+    map->capacity = 1024;
+    map->mask = 2 * map->capacity - 1;
+    map->slots = (long*) malloc(sizeof(long) * (map->mask + 1));
+    map->keys = (unsigned char*) malloc((size_t) keyBytes * map->capacity);
+    map->probs = (double*) malloc(sizeof(double) * map->capacity);
+    memset(map->slots, -1, sizeof(long) * (map->mask + 1));
+}
+
+/*
+    Function: clearStateMap(StateMap* map)
+    Purpose:  Empties a map, keeping its memory for the next layer.
+    Params:
+        Input/Output: StateMap* map - points to the map.
+    Return: void
+*/
+void clearStateMap(StateMap* map){
+    map->count = 0;
+    memset(map->slots, -1, sizeof(long) * (map->mask + 1));
+}
+
+/*
+    Function: freeStateMap(StateMap* map)
+    Purpose:  Frees the memory of a map.
+    Params:
+        Input/Output: StateMap* map - points to the map.
+    Return: void
+*/
+void freeStateMap(StateMap* map){
+    free(map->slots);
+    free(map->keys);
+    free(map->probs);
+    map->slots = NULL;
+    map->keys = NULL;
+    map->probs = NULL;
+}
+
+/*
+    Function: addState(StateMap* map, unsigned char* key, double prob)
+    Purpose:  Adds probability to a state, inserting the state if it is not in the map yet. Open addressing with linear probing,
+              the slots are kept at most half full.
+    Params:
+        Input/Output: StateMap* map - points to the map.
+        Input: unsigned char* key - stores the packed state.
+        Input: double prob - stores the probability being added.
+    Return: void
+*/
+void addState(StateMap* map, unsigned char* key, double prob){
+    long slot = hashKey(key, map->keyBytes) & map->mask;
+    while(map->slots[slot] >= 0){
+        long index = map->slots[slot];
+        if(memcmp(map->keys + index * map->keyBytes, key, map->keyBytes) == 0){
+            map->probs[index] += prob;
+            return;
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    if(map->count == map->capacity){
+        growStateMap(map);
+        addState(map, key, prob);
+        return;
+    }
+    memcpy(map->keys + map->count * map->keyBytes, key, map->keyBytes);
+    map->probs[map->count] = prob;
+    map->slots[slot] = map->count;
+    map->count++;
+}
+
+/*
+    Function: growStateMap(StateMap* map)
+    Purpose:  Doubles the room of a map and puts its states back into the larger slots.
+    Params:
+        Input/Output: StateMap* map - points to a full map.
+    Return: void
+*/
+void growStateMap(StateMap* map){
+    map->capacity *= 2;
+    map->mask = 2 * map->capacity - 1;
+    map->keys = (unsigned char*) realloc(map->keys, (size_t) map->keyBytes * map->capacity);
+    map->probs = (double*) realloc(map->probs, sizeof(double) * map->capacity);
+    free(map->slots);
+    map->slots = (long*) malloc(sizeof(long) * (map->mask + 1));
+    memset(map->slots, -1, sizeof(long) * (map->mask + 1));
+    for(long i = 0; i < map->count; i++){
+        long slot = hashKey(map->keys + i * map->keyBytes, map->keyBytes) & map->mask;
+        while(map->slots[slot] >= 0){
+            slot = (slot + 1) & map->mask;
+        }
+        map->slots[slot] = i;
+    }
+}
+
+/*
+    Function: hashKey(unsigned char* key, int bytes)
+    Purpose:  Hashes a packed state a 64-bit word at a time, with a final mix so the low bits used for the slot depend on every word.
+    Params:
+        Input: unsigned char* key - stores the packed state.
+        Input: int bytes - stores the size of the packed state, a multiple of 8.
+    Return: uint64_t - returns the hash.
+*/
+uint64_t hashKey(unsigned char* key, int bytes){
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(int i = 0; i < bytes; i += sizeof(uint64_t)){
+        uint64_t word;
+        memcpy(&word, key + i, sizeof(uint64_t));
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 32;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    return hash ^ (hash >> 32);
+}
+
+/*
+    Function: printExact(ExactResult* result, Options* options, BatchStats* stats)
+    Purpose:  Prints the outcome probabilities, and the frequencies of a batch next to them if one was played.
+    Params:
+        Input: ExactResult* result - points to the outcome probabilities.
+        Input: Options* options - stores the options the solver ran with.
+        Input: BatchStats* stats - points to the outcomes of the batch, NULL for none.
+    Return: void
+*/
+void printExact(ExactResult* result, Options* options, BatchStats* stats){
+    const char* engineNames[] = {"threads", "virtual", "tick", "lanes", "events"};
+    printf("=======================================\n");
+    printf("Exact outcome of a game with %d hunter%s and 1 ghost\n", options->hunters, options->hunters == 1 ? "" : "s");
+    if(stats != NULL){
+        printf("against %d runs on the %s engine (seed %u)\n", stats->runs, engineNames[options->engine], options->seed);
+    }
+    printf("=======================================\n");
+    if(stats != NULL){
+        printf("                                   exact    sampled  error/se\n");
+    }
+    printExactLine("Ghost wins (all fear):", result->fearWins, stats != NULL ? stats->fearWins : 0, stats);
+    printExactLine("Ghost wins (all boredom):", result->boredomWins, stats != NULL ? stats->boredomWins : 0, stats);
+    printExactLine("Ghost wins (mixed):", result->mixedWins, stats != NULL ? stats->mixedWins : 0, stats);
+    printExactLine("Hunter wins:", result->hunterWins, stats != NULL ? stats->hunterWins : 0, stats);
+    printExactLine("Correct ghostGuess:", result->correctGuesses, stats != NULL ? stats->correctGuesses : 0, stats);
+    printExactLine("Incorrect ghostGuess:", result->incorrectGuesses, stats != NULL ? stats->incorrectGuesses : 0, stats);
+    printf("=======================================\n");
+    printf("    States: %ld over %d hunter turns, at most %ld at once\n", result->states, result->turns, result->largestLayer);
+    if(result->unresolved > 0){
+        printf("    Unresolved: %.6f, more than %d states at once\n", result->unresolved, EXACT_MAX_STATES);
+    }
+}
+
+/*
+    Function: printExactLine(char* label, double prob, int count, BatchStats* stats)
+    Purpose:  Prints one outcome probability, and the frequency of the outcome in a batch with its distance from the
+              probability in standard errors.
+    Params:
+        Input: char* label - stores the name of the outcome.
+        Input: double prob - stores the probability of the outcome.
+        Input: int count - stores the number of games of the batch with the outcome.
+        Input: BatchStats* stats - points to the outcomes of the batch, NULL for none.
+    Return: void
+*/
+void printExactLine(char* label, double prob, int count, BatchStats* stats){
+    if(stats == NULL || stats->runs == 0){
+        printf("    %-28s%9.6f\n", label, prob);
+        return;
+    }
+    double sampled = (double) count / stats->runs;
+    double error = sqrt(prob * (1 - prob) / stats->runs);
+    printf("    %-28s%9.6f  %9.6f  %+8.2f\n", label, prob, sampled, error > 0 ? (sampled - prob) / error : 0.0);
+}
@@ -0,0 +1,203 @@
+#include "defs.h"
+
+//Forward declarations
+void* runWorker(void* voidWorker);
+
+/*
+    Function: runFarm(Options* options, BatchStats* stats)
+    Purpose:  Spreads the batch's games over a fixed pool of worker threads.
+              Run ids are dealt out to per-worker deques up front; a worker that runs dry steals from the others,
+              so a few long games never leave the rest of the cores idle.
+    Params:
+        Input: Options* options - stores the number of runs, the engine and the number of workers.
+        Output: BatchStats* stats - points to the aggregate outcomes, merged from every worker.
+    Return: void
+*/
+void runFarm(Options* options, BatchStats* stats){
+    int numWorkers = options->workers;
+    if(numWorkers <= 0){
+        numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(numWorkers > options->runs){
+        numWorkers = options->runs;
+    }
+    if(numWorkers < 1){
+        numWorkers = 1;
+    }
+    Worker* workers = (Worker*) aligned_alloc(64, sizeof(Worker) * numWorkers);
+    long perWorker = (options->runs + numWorkers - 1) / numWorkers;
+    for(int i = 0; i < numWorkers; i++){
+        workers[i].id = i;
+        workers[i].options = options;
+        workers[i].workers = workers;
+        workers[i].numWorkers = numWorkers;
+        memset(&(workers[i].stats), 0, sizeof(BatchStats));
+        initDeque(&(workers[i].deque), perWorker);
+    }
+    //Deal contiguous blocks of run ids, pushed in reverse so each owner pops them in increasing order
+    for(int i = 0; i < numWorkers; i++){
+        int first = i * perWorker;
+        int last = first + perWorker;
+        if(last > options->runs){
+            last = options->runs;
+        }
+        for(int run = last - 1; run >= first; run--){
+            pushTask(&(workers[i].deque), run);
+        }
+    }
+    for(int i = 0; i < numWorkers; i++){
+        pthread_create(&(workers[i].thread), NULL, runWorker, (void*) &(workers[i]));
+    }
+    memset(stats, 0, sizeof(BatchStats));
+    for(int i = 0; i < numWorkers; i++){
+        pthread_join(workers[i].thread, NULL);
+        mergeStats(stats, &(workers[i].stats));
+        free(workers[i].deque.tasks);
+    }
+    free(workers);
+}
+
+/*
+    Function: runWorker(void* voidWorker)
+    Purpose:  Runs the worker thread. Plays games until neither its own deque nor any other worker's has run ids left.
+    Params:
+        Input/Output: void* voidWorker - points to the Worker that is going to run in the thread.
+    Return: void*
+*/
+void* runWorker(void* voidWorker){
+    Worker* worker = (Worker*) voidWorker;
+    int numHunters = worker->options->hunters;
+    char (*hunterNames)[MAX_STR] = malloc(sizeof(*hunterNames) * numHunters);
+    for(int i = 0; i < numHunters; i++){
+        sprintf(hunterNames[i], "Hunter %d", i + 1);
+    }
+    unsigned int victimSeed = (unsigned int) worker->id + 1;
+    int run;
+    //The lanes engine takes run ids as its lanes free up, and the events engine as its paced games end
+    if(worker->options->engine == ENGINE_LANES){
+        runLanes(worker, hunterNames, &victimSeed);
+    }
+    else if(worker->options->engine == ENGINE_EVENTS){
+        runWheel(worker, hunterNames, &victimSeed);
+    }
+    else{
+        while(findTask(worker, &victimSeed, &run) == C_TRUE){
+            GameResult result;
+            runGame(worker->options, run, hunterNames, &result);
+            //Only this thread touches its accumulator, the totals are merged after the join
+            recordResult(&(worker->stats), &result);
+        }
+    }
+    free(hunterNames);
+    //The games of this thread are over, so its arena can go
+    arenaFree(gameArena());
+    return NULL;
+}
+
+/*
+    Function: findTask(Worker* worker, unsigned int* victimSeed, int* task)
+    Purpose:  Takes the next run id from the worker's own deque, or steals one from another worker.
+              No run ids are pushed once the workers start, so one full sweep of empty deques means the batch is done.
+    Params:
+        Input/Output: Worker* worker - points to the worker looking for work.
+        Input/Output: unsigned int* victimSeed - stores the state used to pick the first victim.
+        Output: int* task - stores the run id found.
+    Return: int - returns C_TRUE if a run id was found, or C_FALSE once every deque is empty
+*/
+int findTask(Worker* worker, unsigned int* victimSeed, int* task){
+    if(popTask(&(worker->deque), task) == C_TRUE){
+        return C_TRUE;
+    }
+    //Start the sweep at a random victim so idle workers don't all hammer the same deque
+    int start = rand_r(victimSeed) % worker->numWorkers;
+    for(int i = 0; i < worker->numWorkers; i++){
+        Worker* victim = &(worker->workers[(start + i) % worker->numWorkers]);
+        if(victim == worker){
+            continue;
+        }
+        if(stealTask(&(victim->deque), task) == C_TRUE){
+            return C_TRUE;
+        }
+    }
+    return C_FALSE;
+}
+
+/*
+    Function: initDeque(TaskDeque* deque, long capacity)
+    Purpose:  Initializes an empty deque able to hold the given number of run ids.
+    Params:
+        Output: TaskDeque* deque - points to the deque being initialized.
+        Input: long capacity - stores the maximum number of run ids held at once.
+    Return: void
+*/
+void initDeque(TaskDeque* deque, long capacity){
+    atomic_init(&(deque->top), 0);
+    atomic_init(&(deque->bottom), 0);
+    deque->capacity = (capacity > 0) ? capacity : 1;
+    deque->tasks = (int*) malloc(sizeof(int) * deque->capacity);
+}
+
+/*
+    Function: pushTask(TaskDeque* deque, int task)
+    Purpose:  Pushes a run id onto the bottom of the deque. Only the owner may push, and the deque must not be full.
+    Params:
+        Input/Output: TaskDeque* deque - points to the deque.
+        Input: int task - stores the run id.
+    Return: void
+*/
+void pushTask(TaskDeque* deque, int task){
+    long bottom = atomic_load_explicit(&(deque->bottom), memory_order_relaxed);
+    deque->tasks[bottom % deque->capacity] = task;
+    atomic_store_explicit(&(deque->bottom), bottom + 1, memory_order_release);
+}
+
+/*
+    Function: popTask(TaskDeque* deque, int* task)
+    Purpose:  Pops a run id from the bottom of the deque. Only the owner may pop.
+    Params:
+        Input/Output: TaskDeque* deque - points to the deque.
+        Output: int* task - stores the run id popped.
+    Return: int - returns C_TRUE if a run id was popped, or C_FALSE if the deque was empty
+*/
+int popTask(TaskDeque* deque, int* task){
+    long bottom = atomic_load_explicit(&(deque->bottom), memory_order_relaxed) - 1;
+    atomic_store_explicit(&(deque->bottom), bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&(deque->top), memory_order_relaxed);
+    if(top > bottom){
+        atomic_store_explicit(&(deque->bottom), bottom + 1, memory_order_relaxed);
+        return C_FALSE;
+    }
+    *task = deque->tasks[bottom % deque->capacity];
+    if(top < bottom){
+        return C_TRUE;
+    }
+    //Last run id left, race the thieves for it
+    int won = atomic_compare_exchange_strong_explicit(&(deque->top), &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&(deque->bottom), bottom + 1, memory_order_relaxed);
+    return won ? C_TRUE : C_FALSE;
+}
+
+/*
+    Function: stealTask(TaskDeque* deque, int* task)
+    Purpose:  Steals a run id from the top of another worker's deque.
+    Params:
+        Input/Output: TaskDeque* deque - points to the victim's deque.
+        Output: int* task - stores the run id stolen.
+    Return: int - returns C_TRUE if a run id was stolen, or C_FALSE if the deque was empty
+*/
+int stealTask(TaskDeque* deque, int* task){
+    while(C_TRUE){
+        long top = atomic_load_explicit(&(deque->top), memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        long bottom = atomic_load_explicit(&(deque->bottom), memory_order_acquire);
+        if(top >= bottom){
+            return C_FALSE;
+        }
+        *task = deque->tasks[top % deque->capacity];
+        if(atomic_compare_exchange_strong_explicit(&(deque->top), &top, top + 1, memory_order_seq_cst, memory_order_relaxed)){
+            return C_TRUE;
+        }
+        //Lost the race to the owner or another thief, look again
+    }
+}
@@ -3,65 +3,81 @@
 //Forward declarations
 void leaveEvidence(Ghost* ghost);
 void moveRoom(Ghost* curGhost);
-void addGhost(Ghost* ghost, Room* entering);
-void removeGhost(Ghost* ghost);
-int isHunterInRoom(Room* curRoom);
 int isGhostLeaving(Ghost* curGhost, int* ghostChoice);
 
 /* 
-    Function: initGhost(RoomList* rooms, Ghost* curGhost)
-    Purpose:  Initializes a Ghost struct.
+    Function: initGhost(HouseType* house, Ghost* curGhost, int id)
+    Purpose:  Initializes a Ghost struct. Every ghost draws its own class and starting room.
     Params:   
-        Input: RoomList* rooms - stores all the rooms in the house so the ghost can randomly choose one to start in.
+        Input: HouseType* house - stores all the rooms in the house so the ghost can randomly choose one to start in.
         Input/Output: Ghost* curGhost - points to the ghost being initialized.
+        Input: int id - stores the ghost's index in the house.
     Return: void
 */
-void initGhost(RoomList* rooms, Ghost* curGhost){
+void initGhost(HouseType* house, Ghost* curGhost, int id){
+    RoomGraph* graph = &(house->graph);
     curGhost->boredomTimer = 0;
+    curGhost->id = id;
+    curGhost->moveStats.moves = 0;
+    curGhost->moveStats.contended = 0;
+    curGhost->house = house;
+    rngInit(&(curGhost->rng), house->runId, RNG_STREAM_GHOST + curGhost->id);
     curGhost->ghostType = randomGhost();
-    int n = randInt(0, (rooms->size)-1);
-    RoomNode* curNode = rooms->head->next;
-    for(int i = 0; i < n; i++){
-        curNode = curNode->next;
-    }
-    curGhost->curRoom = curNode->data;
-    curGhost->curRoom->ghost = curGhost;
-    l_ghostInit(curGhost->ghostType, curGhost->curRoom->roomName);
+    //Any room but the Van, which is room 0
+    int n = randInt(0, (graph->numRooms)-1);
+    curGhost->curRoom = graph->rooms[n + 1];
+    ghostEntered(curGhost->curRoom);
+    l_ghostInit(curGhost);
 }
 
 /* 
     Function: runGhost(void* voidGhost)
-    Purpose:  Runs the ghost thread. 
+    Purpose:  Runs the ghost thread. The ghost stops taking turns once it leaves or the game is decided.
     Params:   
         Input/Output: void* voidGhost - points to the Ghost that is going to run in the thread.
     Return: void*
 */
 void* runGhost(void* voidGhost){
     Ghost* curGhost = (Ghost*) voidGhost;
-    //Loops the ghost so it keeps taking actions
-    while(C_TRUE){
-        usleep(GHOST_WAIT);
-        int ghostChoice;
-        //Checks if the ghost is leaving and returns if so, and performs choice generation
-        if(isGhostLeaving(curGhost, &ghostChoice) == C_TRUE){
+    rngUse(&(curGhost->rng));
+    //Loops the ghost so it keeps taking actions, the wait ends early when the game does
+    while(gameSleep(curGhost->house, GHOST_WAIT) == C_FALSE){
+        if(ghostStep(curGhost) == C_TRUE){
             break;
         }
-        //Leave evidence
-        if(ghostChoice == 0){
-            leaveEvidence(curGhost);
-        }
-        //Do nothing
-        else if(ghostChoice == 1){
-        }
-        //Move
-        else{
-            //Needs update
-            moveRoom(curGhost);
-        }
     }
     return NULL;
 }
 
+/* 
+    Function: ghostStep(Ghost* curGhost)
+    Purpose:  Performs one turn of the ghost. Shared by the threaded and the virtual time engines.
+    Params:   
+        Input/Output: Ghost* curGhost - points to the Ghost taking its turn.
+    Return: int - returns C_TRUE if the ghost left the house this turn, or C_FALSE otherwise
+*/
+int ghostStep(Ghost* curGhost){
+    int ghostChoice;
+    int leaving;
+    //Checks if the ghost is leaving and returns if so, and performs choice generation
+    INSTR_TIME(FN_GHOST_LEAVING, leaving = isGhostLeaving(curGhost, &ghostChoice));
+    if(leaving == C_TRUE){
+        return C_TRUE;
+    }
+    //Leave evidence
+    if(ghostChoice == 0){
+        INSTR_TIME(FN_LEAVE_EVIDENCE, leaveEvidence(curGhost));
+    }
+    //Do nothing
+    else if(ghostChoice == 1){
+    }
+    //Move
+    else{
+        INSTR_TIME(FN_MOVE_GHOST, moveRoom(curGhost));
+    }
+    return C_FALSE;
+}
+
 /* 
     Function: isGhostLeaving(Ghost* curGhost, int* ghostChoice)
     Purpose:  Determine if the ghost is leaving the house
@@ -81,7 +97,7 @@ int isGhostLeaving(Ghost* curGhost, int* ghostChoice){
         curGhost->boredomTimer++;
         *ghostChoice = randInt(0, 3);
         if(curGhost->boredomTimer == BOREDOM_MAX){
-            l_ghostExit(LOG_BORED);
+            l_ghostExit(curGhost, LOG_BORED);
             return C_TRUE;
         }
     }
@@ -96,92 +112,40 @@ int isGhostLeaving(Ghost* curGhost, int* ghostChoice){
     Return: int - returns C_FALSE if there is no hunter in the room or C_TRUE if there is a hunter in the room.
 */
 int isHunterInRoom(Room* curRoom){
-    int hunterInRoom = C_FALSE;
-    //Iterate through list of hunters in room
-    if(sem_wait(&(curRoom->roomHunterMutex)) == 0){
-        for(int i = 0; i < NUM_HUNTERS; i++){
-            if(curRoom->curHunters[i] != NULL){
-                hunterInRoom = C_TRUE;
-            }
-        }
-        sem_post(&(curRoom->roomHunterMutex));
-    }
-    return hunterInRoom;
+    //One bit of the house's hunter bitmap, no lock is taken
+    unsigned long long word = atomic_load_explicit(&(curRoom->graph->hunterRooms[curRoom->id / OCCUPANCY_BITS]), memory_order_relaxed);
+    return ((word >> (curRoom->id % OCCUPANCY_BITS)) & 1) ? C_TRUE : C_FALSE;
 }
 
 /* 
     Function: moveRoom(Ghost* curGhost)
-    Purpose:  Moves the ghost from one room to another randomly selected room.
+    Purpose:  Moves the ghost from one room to another randomly selected room, holding both rooms' ghost locks for the whole move.
     Params:   
         Input/Output: Ghost* curGhost - points to the Ghost moving room.
     Return: void
 */
 void moveRoom(Ghost* curGhost){
     //Selects the room to move to
-    Room* entering = selectConnectedRoom(curGhost->curRoom, &(curGhost->curRoom->roomGhostMutex));
-    removeGhost(curGhost); 
-    addGhost(curGhost, entering);
-}
-
-/* 
-    Function: removeGhost(Ghost* ghost)
-    Purpose:  Removes a ghost from its current room.
-    Params:   
-        Input/Output: Ghost* ghost - points to the Ghost being removed from it's current room.
-    Return: void
-*/
-void removeGhost(Ghost* ghost){
-    if(sem_wait(&(ghost->curRoom->roomGhostMutex)) == 0){
-        ghost->curRoom->ghost = NULL;
-        sem_post(&(ghost->curRoom->roomGhostMutex));
-    }
-}
-
-/* 
-    Function: addGhost(Ghost* ghost, Room* entering)
-    Purpose:  Adds a given ghost to the specified room.
-    Params:   
-        Input/Output: Ghost* ghost - points to the Ghost being added to the specified room.
-        Input/Output: Room* entering - points to the room the Ghost is entering.
-    Return: void
-*/
-void addGhost(Ghost* ghost, Room* entering){
-    if(sem_wait(&(entering->roomGhostMutex)) == 0){
-        ghost->curRoom = entering;
-        ghost->curRoom->ghost = ghost;
-        l_ghostMove(ghost->curRoom->roomName);
-        sem_post(&(entering->roomGhostMutex));
-    }
+    Room* leaving = curGhost->curRoom;
+    Room* entering = selectConnectedRoom(leaving);
+    lockRoomPair(&(leaving->roomGhostMutex), leaving, &(entering->roomGhostMutex), entering, &(curGhost->moveStats));
+    ghostLeft(leaving);
+    ghostEntered(entering);
+    curGhost->curRoom = entering;
+    l_ghostMove(curGhost, entering);
+    unlockRoomPair(&(leaving->roomGhostMutex), &(entering->roomGhostMutex));
 }
 
 /* 
     Function: leaveEvidence(Ghost* ghost)
-    Purpose:  Allow the ghost to leave evidence inside a room.
+    Purpose:  Allow the ghost to leave evidence inside a room. The evidence is marked with the ghost's class, so the hunters can tell apart what different kinds of ghost left.
     Params:   
         Input: Ghost* ghost - points to the Ghost leaving evidence.
     Return: void
 */
 void leaveEvidence(Ghost* ghost){
-    int n;
-    while(C_TRUE){
-        //Randomly selects a piece of evidence to leave, and ensures the ghost can leave that type of evidence. If it can't, tries again.
-        n = randInt(0, EV_COUNT);
-        if(ghost->ghostType == POLTERGEIST && n != SOUND){
-            addEvidence(&(ghost->curRoom->evidenceList), n);
-            break;
-        }
-        else if(ghost->ghostType == BANSHEE && n != FINGERPRINTS){
-            addEvidence(&(ghost->curRoom->evidenceList), n);
-            break;
-        }
-        else if(ghost->ghostType == BULLIES && n != TEMPERATURE){
-            addEvidence(&(ghost->curRoom->evidenceList), n);
-            break;
-        }
-        else if(ghost->ghostType == PHANTOM && n != EMF){
-            addEvidence(&(ghost->curRoom->evidenceList), n);
-            break;
-        }
-    }
-    l_ghostEvidence(n, ghost->curRoom->roomName);
+    //One draw from the types the ghost's class leaves
+    EvidenceType n = ghostEvidence[ghost->ghostType][randInt(0, DESIRED_EVIDENCE_COUNT)];
+    dropEvidence(&(ghost->curRoom->evidence), ghost->ghostType, n);
+    l_ghostEvidence(ghost, n, ghost->curRoom);
 }
@@ -1,44 +1,221 @@
 #include "defs.h"
 
 /* 
-    Function: initProgram(HouseType* house, Ghost* ghost)
+    Function: initProgram(HouseType* house, int numHunters, int numGhosts)
     Purpose:  Initialize the program so the game can run.
     Params:   
         Input/Output: HouseType* house - points to the house beinging initialized.
-        Input/Output: Ghost* ghost - points to the ghost being initialized.
+        Input: int numHunters - stores the number of hunters in the game.
+        Input: int numGhosts - stores the number of ghosts in the game.
     Return: void
 */
-void initProgram(HouseType* house, Ghost* ghost){
-    char hunterNames[NUM_HUNTERS][MAX_STR];
-    //Ask the user to input 4 hunter names
-    getNames(hunterNames);
-    // Initialize the random number generator
-    srand(time(NULL));
+void initProgram(HouseType* house, int numHunters, int numGhosts){
+    char (*hunterNames)[MAX_STR] = malloc(sizeof(*hunterNames) * numHunters);
+    //Ask the user to input the hunter names
+    getNames(hunterNames, numHunters);
+    initGame(house, hunterNames, numHunters, numGhosts, 0);
+    free(hunterNames);
+}
+
+/* 
+    Function: initGame(HouseType* house, char hunterNames[][MAX_STR], int numHunters, int numGhosts, int runId)
+    Purpose:  Builds a fresh house, hunters and ghosts so a game can run. Every piece of state a previous game touched is reset.
+    Params:   
+        Input/Output: HouseType* house - points to the house being initialized, it owns the hunters and ghosts.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters.
+        Input: int numHunters - stores the number of hunters.
+        Input: int numGhosts - stores the number of ghosts.
+        Input: int runId - stores the id of the run, which keys the random streams of the game and tags its binary trace.
+    Return: void
+*/
+void initGame(HouseType* house, char hunterNames[][MAX_STR], int numHunters, int numGhosts, int runId){
     initHouse(house);
-    populateRooms(house);
-    //Initialize hunters & Place hunters in head of our room list
-    for(int i = 0; i < NUM_HUNTERS; i++){
-        house->curHunters[i] = initHunter(hunterNames[i], house->rooms.head->data, i, &(house->sharedEvidence));
-    }
-    //Adds the hunter to the van's list of current hunters when it is initialized
-    for(int i = 0; i < NUM_HUNTERS; i++) {
-        if(house->rooms.head->data->curHunters[i] == NULL) {
-            house->rooms.head->data->curHunters[i] = &(house->curHunters[i]);
+    //Everything drawn while setting up the game comes from the house's own stream
+    house->runId = runId;
+    rngInit(&(house->rng), runId, RNG_STREAM_HOUSE);
+    rngUse(&(house->rng));
+    //The loaded house file if there is one, or the built in floor plan
+    if(buildLoadedHouse(house) == C_FALSE){
+        populateRooms(house);
+        compileHouse(house);
+    }
+    initOccupancy(&(house->graph), house->arena);
+    house->numHunters = numHunters;
+    initGameEnd(&(house->end), numHunters);
+    house->curHunters = (Hunter*) arenaAlloc(house->arena, sizeof(Hunter) * numHunters);
+    INSTR_BEGIN_GAME(house);
+    house->numGhosts = numGhosts;
+    house->curGhosts = (Ghost*) arenaAlloc(house->arena, sizeof(Ghost) * numGhosts);
+    //Tracing starts before the agents exist so their init events are recorded
+    traceBeginGame(house, runId, hunterNames);
+    Room* van = house->graph.rooms[0];
+    //Initialize hunters & Place hunters in the van, the equipment goes round the evidence types
+    for(int i = 0; i < numHunters; i++){
+        house->curHunters[i] = initHunter(house, i, hunterNames[i], i % EV_COUNT);
+    }
+    //Adds the hunter to the van's list of current hunters once the array no longer moves
+    for(int i = 0; i < numHunters; i++) {
+        linkHunter(van, &(house->curHunters[i]));
+    }
+    for(int i = 0; i < numGhosts; i++){
+        initGhost(house, &(house->curGhosts[i]), i);
+    }
+    rngUse(NULL);
+}
+
+/* 
+    Function: parseOptions(int argc, char* argv[], Options* options)
+    Purpose:  Reads the command line options.
+    Params:   
+        Input: int argc - stores the number of command line arguments.
+        Input: char* argv[] - stores the command line arguments.
+        Output: Options* options - points to the options being filled in, the seed is taken from the clock if none was given.
+    Return: int - returns C_TRUE if the options are valid, or C_FALSE otherwise.
+*/
+int parseOptions(int argc, char* argv[], Options* options){
+    options->runs = 0;
+    options->seed = 0;
+    options->seeded = C_FALSE;
+    options->engine = ENGINE_THREADS;
+    options->workers = 0;
+    options->hunters = NUM_HUNTERS;
+    options->ghosts = NUM_GHOSTS;
+    options->logMode = LOG_SYNC;
+    options->tracePath = NULL;
+    options->housePath = NULL;
+    options->generate = C_FALSE;
+    options->exact = C_FALSE;
+    options->live = LIVE_GAMES;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc){
+            options->runs = atoi(argv[++i]);
+            if(options->runs <= 0){
+                fprintf(stderr, "--runs must be a positive number\n");
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            options->seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+            options->seeded = C_TRUE;
+        }
+        else if(strcmp(argv[i], "--workers") == 0 && i + 1 < argc){
+            options->workers = atoi(argv[++i]);
+            if(options->workers < 0){
+                fprintf(stderr, "--workers must not be negative\n");
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--live") == 0 && i + 1 < argc){
+            options->live = atoi(argv[++i]);
+            if(options->live < 1 || options->live > MAX_LIVE){
+                fprintf(stderr, "--live must be between 1 and %d\n", MAX_LIVE);
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--hunters") == 0 && i + 1 < argc){
+            options->hunters = atoi(argv[++i]);
+            if(options->hunters < 1 || options->hunters > MAX_HUNTERS){
+                fprintf(stderr, "--hunters must be between 1 and %d\n", MAX_HUNTERS);
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--ghosts") == 0 && i + 1 < argc){
+            options->ghosts = atoi(argv[++i]);
+            if(options->ghosts < 1 || options->ghosts > MAX_GHOSTS){
+                fprintf(stderr, "--ghosts must be between 1 and %d\n", MAX_GHOSTS);
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--log") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "sync") == 0){
+                options->logMode = LOG_SYNC;
+            }
+            else if(strcmp(argv[i], "async") == 0){
+                options->logMode = LOG_ASYNC_BLOCK;
+            }
+            else if(strcmp(argv[i], "async-drop") == 0){
+                options->logMode = LOG_ASYNC_DROP;
+            }
+            else{
+                fprintf(stderr, "Unknown log mode '%s', expected sync, async or async-drop\n", argv[i]);
+                return C_FALSE;
+            }
+        }
+        else if(strcmp(argv[i], "--house") == 0 && i + 1 < argc){
+            options->housePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--generate") == 0 && i + 1 < argc){
+            if(parseGenSpec(argv[++i], &(options->genSpec)) == C_FALSE){
+                fprintf(stderr, "Bad house spec '%s', expected grid|tree|smallworld|clusters:ROOMS[:DEGREE[:uniform|power]]\n", argv[i]);
+                return C_FALSE;
+            }
+            options->generate = C_TRUE;
+        }
+        else if(strcmp(argv[i], "--exact") == 0){
+            options->exact = C_TRUE;
         }
+        else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+            options->tracePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "threads") == 0){
+                options->engine = ENGINE_THREADS;
+            }
+            else if(strcmp(argv[i], "virtual") == 0){
+                options->engine = ENGINE_VIRTUAL;
+            }
+            else if(strcmp(argv[i], "tick") == 0){
+                options->engine = ENGINE_TICK;
+            }
+            else if(strcmp(argv[i], "lanes") == 0){
+                options->engine = ENGINE_LANES;
+            }
+            else if(strcmp(argv[i], "events") == 0){
+                options->engine = ENGINE_EVENTS;
+            }
+            else{
+                fprintf(stderr, "Unknown engine '%s', expected threads, virtual, tick, lanes or events\n", argv[i]);
+                return C_FALSE;
+            }
+        }
+        else{
+            fprintf(stderr, "Usage: %s [--runs N] [--seed S] [--engine threads|virtual|tick|lanes|events] [--workers W] [--live L] [--hunters H] [--ghosts G] [--log sync|async|async-drop] [--trace FILE] [--house FILE | --generate SPEC] [--exact]\n", argv[0]);
+            return C_FALSE;
+        }
+    }
+    if(options->housePath != NULL && options->generate == C_TRUE){
+        fprintf(stderr, "--house and --generate cannot be used together\n");
+        return C_FALSE;
+    }
+    //The lanes never log, so there are no events to trace
+    if(options->tracePath != NULL && options->engine == ENGINE_LANES && options->runs > 0){
+        fprintf(stderr, "--trace cannot be used with a batch on the lanes engine\n");
+        return C_FALSE;
     }
-    initGhost(&(house->rooms), ghost);
+    //Without a seed every run is different
+    if(options->seeded == C_FALSE){
+        options->seed = (unsigned int) time(NULL);
+    }
+    return C_TRUE;
 }
 
 /* 
-    Function: getNames(char hunterNames[][MAX_STR])
-    Purpose:  Get the names of the hunters from the user.
+    Function: getNames(char hunterNames[][MAX_STR], int numHunters)
+    Purpose:  Get the names of the hunters from the user. Only the first four are asked for, any others are numbered.
     Params:   
         Output: char hunterNames[][MAX_STR] - stores all of the hunter's names entered by the user.
+        Input: int numHunters - stores the number of hunters.
     Return: void
 */
-void getNames(char hunterNames[][MAX_STR]){
+void getNames(char hunterNames[][MAX_STR], int numHunters){
     char hunterNumber[NUM_HUNTERS][MAX_STR] = {"first", "second", "third", "fourth"};
-    for(int i = 0; i < NUM_HUNTERS; i++){
+    for(int i = 0; i < numHunters; i++){
+        if(i >= NUM_HUNTERS){
+            sprintf(hunterNames[i], "Hunter %d", i + 1);
+            continue;
+        }
         printf("Enter the name of the %s hunter: ", hunterNumber[i]);
         fgets(hunterNames[i], MAX_STR, stdin);
         hunterNames[i][strlen(hunterNames[i])-1] = 0;    
@@ -46,62 +223,96 @@ void getNames(char hunterNames[][MAX_STR]){
 }
 
 /* 
-    Function: runThreads(HouseType* house, Ghost* ghost)
+    Function: runThreads(HouseType* house)
     Purpose:  Runs all of the threads for the program (ghost and hunter's threads).
     Params:   
-        Input: HouseType* house - points to the house storing all of the hunters.
-        Input: Ghost* ghost - points to the ghost.
+        Input: HouseType* house - points to the house storing all of the hunters and ghosts.
     Return: void
 */
-void runThreads(HouseType* house, Ghost* ghost){
-    pthread_t ghostThread;
-    pthread_t hunterIDs[NUM_HUNTERS];
-    //Creating ghost thread
-    pthread_create(&ghostThread, NULL, runGhost, (void*) ghost);
+void runThreads(HouseType* house){
+    pthread_t* ghostIDs = (pthread_t*) arenaAlloc(house->arena, sizeof(pthread_t) * house->numGhosts);
+    pthread_t* hunterIDs = (pthread_t*) arenaAlloc(house->arena, sizeof(pthread_t) * house->numHunters);
+    //Creating ghost threads
+    for(int i = 0; i < house->numGhosts; i++){
+        pthread_create(&ghostIDs[i], NULL, runGhost, (void*) &(house->curGhosts[i]));
+    }
     //Creating hunter threads
-    for(int i = 0; i < NUM_HUNTERS; i++){
+    for(int i = 0; i < house->numHunters; i++){
         pthread_create(&hunterIDs[i], NULL, runHunter, (void*) &(house->curHunters[i]));
     }
     //Waiting for all threads to complete
-    pthread_join(ghostThread, NULL);
-    for(int i = 0; i < NUM_HUNTERS; i++){
+    for(int i = 0; i < house->numGhosts; i++){
+        pthread_join(ghostIDs[i], NULL);
+    }
+    for(int i = 0; i < house->numHunters; i++){
         pthread_join(hunterIDs[i], NULL);
     }
 }
 
 /* 
-    Function: printEnd(HouseType house, GhostClass actualType)
+    Function: printEnd(HouseType* house)
     Purpose:  Prints the ending sequence/results after the program.
     Params:   
-        Input: HouseType* house - points to the house storing all of the hunters.
-        Input: Ghost* ghost - points to the ghost.
+        Input: HouseType* house - points to the house storing all of the hunters and ghosts.
     Return: void
 */
-void printEnd(HouseType house, GhostClass actualType){
-    printEndIntro(house.curHunters);
-    
-    EvidenceType found[DESIRED_EVIDENCE_COUNT];
-    printEvidence(house.sharedEvidence, found);
-    GhostClass ghostDetermined = ghostGuess(house.sharedEvidence.size, found);
+void printEnd(HouseType* house){
+    printEndIntro(house->curHunters, house->numHunters, house->numGhosts);
+    printEvidence(&(house->sharedEvidence));
+    printEndRemainder(identifyGhosts(&(house->sharedEvidence)), ghostClasses(house));
+}
 
-    printEndRemainder(ghostDetermined, actualType);
+/* 
+    Function: evaluateGame(HouseType* house, GameResult* result)
+    Purpose:  Tallies the outcome of a finished game without printing anything.
+    Params:   
+        Input: HouseType* house - points to the house storing all of the hunters, the ghosts and the shared evidence.
+        Output: GameResult* result - points to the result being filled in (the length is left to the caller).
+    Return: void
+*/
+void evaluateGame(HouseType* house, GameResult* result){
+    result->fearCount = 0;
+    result->boredCount = 0;
+    result->numHunters = house->numHunters;
+    for(int i = 0; i < house->numHunters; i++){
+        if(house->curHunters[i].fear >= FEAR_MAX){
+            result->fearCount++;
+        }
+        else if(house->curHunters[i].boredom >= BOREDOM_MAX){
+            result->boredCount++;
+        }
+    }
+    result->guess = identifyGhosts(&(house->sharedEvidence));
+    result->actual = ghostClasses(house);
+    result->moveStats.moves = 0;
+    result->moveStats.contended = 0;
+    for(int i = 0; i < house->numHunters; i++){
+        result->moveStats.moves += house->curHunters[i].moveStats.moves;
+        result->moveStats.contended += house->curHunters[i].moveStats.contended;
+    }
+    for(int i = 0; i < house->numGhosts; i++){
+        result->moveStats.moves += house->curGhosts[i].moveStats.moves;
+        result->moveStats.contended += house->curGhosts[i].moveStats.contended;
+    }
 }
 
 /* 
-    Function: printEndIntro(Hunter curHunters[NUM_HUNTERS])
+    Function: printEndIntro(Hunter* curHunters, int numHunters, int numGhosts)
     Purpose:  Prints the intro of the ending sequence/results after the program.
     Params:   
-        Input: Hunter curHunters[NUM_HUNTERS] - stores all of the hunters in the program.
+        Input: Hunter* curHunters - stores all of the hunters in the program.
+        Input: int numHunters - stores the number of hunters.
+        Input: int numGhosts - stores the number of ghosts, with several the hunters win without finding every one.
     Return: void
 */
-void printEndIntro(Hunter curHunters[NUM_HUNTERS]){
+void printEndIntro(Hunter* curHunters, int numHunters, int numGhosts){
     printf("=======================================\n");
     printf("All done! Let's tally the results...\n");
     printf("=======================================\n");
     int numOfRunawaysDueToFear = 0;
     int numOfRunawaysDueToBoredom = 0;
     //Prints all hunters that have fear >= FEAR_MAX
-    for(int i = 0; i < NUM_HUNTERS; i++){
+    for(int i = 0; i < numHunters; i++){
         if(curHunters[i].fear >= FEAR_MAX){
             printf("    * %s has run way in fear!\n", curHunters[i].hunterName);
             numOfRunawaysDueToFear++;
@@ -109,46 +320,118 @@ void printEndIntro(Hunter curHunters[NUM_HUNTERS]){
     }
     //Prints all hunters that have boredom >= BOREDOM_MAX
     printf("=======================================\n");
-    for(int i = 0; i < NUM_HUNTERS; i++){
+    for(int i = 0; i < numHunters; i++){
         if(curHunters[i].boredom >= BOREDOM_MAX){
             printf("    * %s has left due to boredom!\n", curHunters[i].hunterName);
             numOfRunawaysDueToBoredom++;
         }
     }
     
-    if(numOfRunawaysDueToFear >= NUM_HUNTERS){
+    if(numOfRunawaysDueToFear >= numHunters){
         printf("All the hunters have run away in fear!\n");
     }
-    else if(numOfRunawaysDueToBoredom >= NUM_HUNTERS){
+    else if(numOfRunawaysDueToBoredom >= numHunters){
         printf("All the hunters have left due to boredom!\n");
     }
     
-    if((numOfRunawaysDueToFear+numOfRunawaysDueToBoredom) >= NUM_HUNTERS){
+    if((numOfRunawaysDueToFear+numOfRunawaysDueToBoredom) >= numHunters){
         printf("The ghost has won!\nThe hunters failed!\n");
     } 
+    //With several ghosts the evidence is sufficient once every kind the hunters found evidence of is identified,
+    //kinds that left no evidence they found can still be haunting the house
+    else if(numGhosts > 1){
+        printf("The hunters identified every kind of ghost they found evidence of!\nThe hunters have won the game!\n");
+    }
     else {
         printf("It seems the ghost has been discovered!\nThe hunters have won the game!\n");
     }
 }
 
 /* 
-    Function: printEvidence(EvidenceList sharedEvidence, EvidenceType found[DESIRED_EVIDENCE_COUNT])
-    Purpose:  Prints the evidence of the ending sequence/results after the program.
+    Function: printEvidence(SharedEvidence* sharedEvidence)
+    Purpose:  Prints the evidence of the ending sequence/results after the program, grouped by the kind of ghost that left it.
     Params:   
-        Input: EvidenceList sharedEvidence - stores all of the evidence collected by the hunters.
-        output: EvidenceType found[DESIRED_EVIDENCE_COUNT] -stores all of the evidence found by the hunters. 
+        Input: SharedEvidence* sharedEvidence - points to all of the evidence collected by the hunters.
     Return: void
 */
-void printEvidence(EvidenceList sharedEvidence, EvidenceType found[DESIRED_EVIDENCE_COUNT]){
+void printEvidence(SharedEvidence* sharedEvidence){
     printf("The hunters collected the following evidence: \n");
-    EvidenceNode* curNode = sharedEvidence.head;
-    for(int i = 0; i < sharedEvidence.size; i++) {
-        char str[MAX_STR];
-        evidenceToString(curNode->data, str);
-        printf("    * %s\n", str);
-        found[i] = curNode->data;
-        curNode = curNode->next;
+    //The groups are only labelled when more than one kind of ghost left evidence
+    unsigned int collected = atomic_load(&(sharedEvidence->found));
+    int groups = 0;
+    for(int ghostType = 0; ghostType < GHOST_COUNT; ghostType++){
+        if((collected >> (ghostType * EV_COUNT)) & ((1u << EV_COUNT) - 1)){
+            groups++;
+        }
+    }
+    int group = 0;
+    for(int ghostType = 0; ghostType < GHOST_COUNT; ghostType++){
+        EvidenceType found[EV_COUNT];
+        int size = getSharedEvidence(sharedEvidence, ghostType, found);
+        if(size > 0 && groups > 1){
+            printf("  Left by kind of ghost %d:\n", ++group);
+        }
+        for(int i = 0; i < size; i++) {
+            char str[MAX_STR];
+            evidenceToString(found[i], str);
+            printf("    * %s\n", str);
+        }
+    }
+}
+
+/* 
+    Function: getSharedEvidence(SharedEvidence* sharedEvidence, GhostClass ghostType, EvidenceType found[EV_COUNT])
+    Purpose:  Rebuilds the ordered list of evidence the hunters collected from one kind of ghost. Only valid once every hunter has stopped.
+    Params:   
+        Input: SharedEvidence* sharedEvidence - points to all of the evidence collected by the hunters.
+        Input: GhostClass ghostType - stores the kind of ghost whose evidence is wanted.
+        Output: EvidenceType found[EV_COUNT] - stores the evidence types in the order they were first collected.
+    Return: int - returns the number of evidence types collected.
+*/
+int getSharedEvidence(SharedEvidence* sharedEvidence, GhostClass ghostType, EvidenceType found[EV_COUNT]){
+    int total = atomic_load(&(sharedEvidence->size));
+    int size = 0;
+    for(int i = 0; i < total; i++){
+        if(sharedEvidence->order[i] / EV_COUNT == (int) ghostType){
+            found[size++] = sharedEvidence->order[i] % EV_COUNT;
+        }
+    }
+    return size;
+}
+
+/* 
+    Function: identifyGhosts(SharedEvidence* sharedEvidence)
+    Purpose:  Identifies the class of each kind of ghost from the evidence types collected of it, one table lookup per kind.
+              Only valid once every hunter has stopped.
+    Params:   
+        Input: SharedEvidence* sharedEvidence - points to all of the evidence collected by the hunters.
+    Return: unsigned int - returns the ghost classes the hunters identified, one bit per GhostClass.
+*/
+unsigned int identifyGhosts(SharedEvidence* sharedEvidence){
+    unsigned int determined = 0;
+    unsigned int collected = atomic_load(&(sharedEvidence->found));
+    for(int ghostType = 0; ghostType < GHOST_COUNT; ghostType++){
+        GhostClass guess = ghostByMask(collected >> (ghostType * EV_COUNT));
+        if(guess != GH_UNKNOWN){
+            determined |= 1u << guess;
+        }
+    }
+    return determined;
+}
+
+/* 
+    Function: ghostClasses(HouseType* house)
+    Purpose:  Collects the classes of the ghosts haunting the house.
+    Params:   
+        Input: HouseType* house - points to the house storing all of the ghosts.
+    Return: unsigned int - returns the classes of the ghosts, one bit per GhostClass.
+*/
+unsigned int ghostClasses(HouseType* house){
+    unsigned int classes = 0;
+    for(int i = 0; i < house->numGhosts; i++){
+        classes |= 1u << house->curGhosts[i].ghostType;
     }
+    return classes;
 }
 
 /* 
@@ -160,153 +443,156 @@ void printEvidence(EvidenceList sharedEvidence, EvidenceType found[DESIRED_EVIDE
     Return: Ghostclass - returns the supposed ghost, based of the hunter's shared evidence collection.
 */
 GhostClass ghostGuess(int sharedEvidenceSize, EvidenceType* found){
-    GhostClass temp = GH_UNKNOWN;
-    if(sharedEvidenceSize == DESIRED_EVIDENCE_COUNT){
-        if((found[0] != SOUND) && (found[1] != SOUND) && (found[2] != SOUND)){
-            temp = POLTERGEIST;
-        }
-        else if((found[0] != EMF) && (found[1] != EMF) && (found[2] != EMF)){
-            temp = PHANTOM;
-        }
-        if((found[0] != TEMPERATURE) && (found[1] != TEMPERATURE) && (found[2] != TEMPERATURE)){
-            temp = BULLIES;
-        }
-        if((found[0] != FINGERPRINTS) && (found[1] != FINGERPRINTS) && (found[2] != FINGERPRINTS)){
-            temp = BANSHEE;
-        }
+    unsigned int evidence = 0;
+    for(int i = 0; i < sharedEvidenceSize; i++){
+        evidence |= 1u << found[i];
     }
-    return temp;
+    return ghostByMask(evidence);
+}
+
+/* 
+    Function: ghostByMask(unsigned int evidence)
+    Purpose:  Looks up the ghost class that leaves exactly the given evidence types, in the table generated from GHOST_TABLE.
+    Params:   
+        Input: unsigned int evidence - stores the evidence types found, one bit per EvidenceType.
+    Return: Ghostclass - returns the class leaving those types, or GH_UNKNOWN if no class leaves exactly those.
+*/
+GhostClass ghostByMask(unsigned int evidence){
+    int entry = ghostByEvidence[evidence & ((1u << EV_COUNT) - 1)];
+    return (entry != 0) ? (GhostClass) (entry - 1) : GH_UNKNOWN;
 }
 
 /* 
-    Function: printEndRemainder(GhostClass ghostDetermined, GhostClass actualType)
+    Function: printEndRemainder(unsigned int determined, unsigned int actual)
     Purpose:  Prints the remainder of the ending sequence/results after the program.
     Params:   
-        Input: GhostClass ghostDetermined - stores the ghost determined based of the hunter's shared evidence collection.
-        Input: GhostClass actualType - stores the actual type of the ghost.
+        Input: unsigned int determined - stores the ghost classes determined based of the hunter's shared evidence collection, one bit per GhostClass.
+        Input: unsigned int actual - stores the actual classes of the ghosts.
     Return: void
 */
-void printEndRemainder(GhostClass ghostDetermined, GhostClass actualType){
+void printEndRemainder(unsigned int determined, unsigned int actual){
     char ghostTypeGuess[MAX_STR];
-    ghostToString(ghostDetermined, ghostTypeGuess);
     char ghostType[MAX_STR];
-    ghostToString(actualType, ghostType);
-    if(ghostDetermined == actualType){
-        printf("Using the evidence they found, they correctly determined that the ghost is a %s\n", ghostTypeGuess);
+    //A single kind of ghost gets the verdict the game has always printed
+    if(__builtin_popcount(actual) == 1 && __builtin_popcount(determined) <= 1){
+        ghostToString((determined != 0) ? (GhostClass) __builtin_ctz(determined) : GH_UNKNOWN, ghostTypeGuess);
+        ghostToString(__builtin_ctz(actual), ghostType);
+        if(determined == actual){
+            printf("Using the evidence they found, they correctly determined that the ghost is a %s\n", ghostTypeGuess);
+        }
+        else{
+            printf("Using the evidence they found, they incorrectly determined that the ghost is a %s\nThe ghost is actually %s\n", ghostTypeGuess, ghostType);
+        }
+        return;
     }
-    else{
-        printf("Using the evidence they found, they incorrectly determined that the ghost is a %s\nThe ghost is actually %s\n", ghostTypeGuess, ghostType);
+    for(int ghostClass = 0; ghostClass < GHOST_COUNT; ghostClass++){
+        ghostToString(ghostClass, ghostType);
+        unsigned int bit = 1u << ghostClass;
+        if((actual & bit) && (determined & bit)){
+            printf("Using the evidence they found, they correctly determined that a %s is haunting the house\n", ghostType);
+        }
+        else if(actual & bit){
+            printf("The hunters failed to identify the %s haunting the house\n", ghostType);
+        }
+        else if(determined & bit){
+            printf("Using the evidence they found, they incorrectly determined that a %s is haunting the house\n", ghostType);
+        }
     }
 }
 
 /* 
-    Function: freeProgram(RoomNode* head, EvidenceList sharedEvidence)
+    Function: freeProgram(HouseType* house)
     Purpose:  Frees all dynamically allocated memory associated with the program.
     Params:   
-        Input/Output: RoomNode* head - points to the head of the house's room list.
-        Input/Output: EvidenceList sharedEvidence - stores the hunter's shared evidence list.
+        Input/Output: HouseType* house - points to the house whose hunters, ghosts, rooms and room graph are freed.
     Return: void
 */
-void freeProgram(RoomNode* head, EvidenceList sharedEvidence){
-    RoomNode* curRoom = head;
-    //Iterates through each room in the house
-    while(curRoom != NULL){
-        RoomNode* tempNext = curRoom->next;
-        deallocateRoom(curRoom);
-        curRoom = tempNext;
-    }
-    deallocateSharedEvidenceList(sharedEvidence);
+void freeProgram(HouseType* house){
+    //Every allocation of the game came from its arena, so one release frees them all and keeps the memory for the next game
+    arenaRelease(house->arena, house->arenaMark);
+    freeGameEnd(&(house->end));
+    house->curHunters = NULL;
+    house->curGhosts = NULL;
+    house->graph.rooms = NULL;
 }
 
 /* 
-    Function: deallocateRoom(RoomNode* roomNode)
-    Purpose:  Deallocates a room.
+    Function: dropEvidence(RoomEvidence* evidence, GhostClass ghostType, EvidenceType evType)
+    Purpose:  Leaves a piece of evidence in a room.
     Params:   
-        Input/Output: RoomNode* roomNode - points to the room being deallocated.
+        Input/Output: RoomEvidence* evidence - points to the evidence of the room where evidence is being left.
+        Input: GhostClass ghostType - stores the class of the ghost leaving the evidence.
+        Input: EvidenceType evType - stores the evidence type being left.
     Return: void
 */
-void deallocateRoom(RoomNode* roomNode){
-    EvidenceNode* curEvidenceNode = roomNode->data->evidenceList.head;
-    //Iterates through all the evidence in each room
-    while(curEvidenceNode != NULL){
-        EvidenceNode* tempNext = curEvidenceNode->next;
-        free(curEvidenceNode);
-        curEvidenceNode = tempNext;
-    }    
-    RoomNode* curRoomNode = roomNode->data->connectedRooms.head;
-    //Iterates though each room in the room's connected rooms
-    while(curRoomNode != NULL){
-        RoomNode* tempNext = curRoomNode->next;
-        free(curRoomNode);
-        curRoomNode = tempNext;
-    }
-    free(roomNode->data);
-    free(roomNode);
+void dropEvidence(RoomEvidence* evidence, GhostClass ghostType, EvidenceType evType){
+    LOCK(&(evidence->evidenceMutex));
+    evidence->counts[ghostType][evType]++;
+    UNLOCK(&(evidence->evidenceMutex));
 }
 
 /* 
-    Function: deallocateSharedEvidenceList(EvidenceList sharedEvidence)
-    Purpose:  Deallocates the hunter's shared evidence list.
+    Function: selectConnectedRoom(Room* curRoom)
+    Purpose:  Selects a room for the given entity to move into next. The room graph never changes once the game starts, so no lock is taken.
     Params:   
-        Input/Output: EvidenceList sharedEvidence - points to the shared evidence list being deallocated.
-    Return: void
+        Input: Room* curRoom - points to room where the entity currently is.
+    Return: Room* - returns a pointer to a randomly selected connected room.
 */
-void deallocateSharedEvidenceList(EvidenceList sharedEvidence){
-    EvidenceNode* curEvidenceNode = sharedEvidence.head;
-    while(curEvidenceNode != NULL){
-        EvidenceNode* tempNext = curEvidenceNode->next;
-        free(curEvidenceNode);
-        curEvidenceNode = tempNext;
-    }    
+Room* selectConnectedRoom(Room* curRoom){
+    //Randomly selects room from connected rooms, one index into the room's slice of the neighbour array
+    RoomGraph* graph = curRoom->graph;
+    int first = graph->offsets[curRoom->id];
+    int n = randInt(0, graph->offsets[curRoom->id + 1] - first);
+    return graph->rooms[graph->neighbours[first + n]];
 }
 
 /* 
-    Function: addEvidence(EvidenceList* evList, EvidenceType evType, sem_t* mutex)
-    Purpose:  Adds evidence to a given evidence list.
+    Function: lockRoomPair(RoomLock* fromMutex, Room* from, RoomLock* toMutex, Room* to, MoveStats* stats)
+    Purpose:  Locks the same kind of mutex in the two rooms of a move, lowest room id first so two agents moving in
+              opposite directions can never deadlock. Each lock is tried first, so the agent can count the ones it had to wait for.
+              A room connected to itself has one mutex, which is locked once and not counted as contended.
     Params:   
-        Input/Output: EvidenceList* evList - points to evidence list where evidence is being added.
-        Input: EvidenceType evType - stores the evidence type being added to the evidence list.
+        Input/Output: RoomLock* fromMutex - points to the mutex of the room being left.
+        Input: Room* from - points to the room being left.
+        Input/Output: RoomLock* toMutex - points to the same mutex of the room being entered.
+        Input: Room* to - points to the room being entered.
+        Input/Output: MoveStats* stats - points to the moving agent's counters.
     Return: void
 */
-void addEvidence(EvidenceList* evList, EvidenceType evType){
-    if(sem_wait(&(evList->evidenceMutex)) == 0){
-        EvidenceNode* new = (EvidenceNode*) malloc(sizeof(EvidenceNode));
-        new->data = evType;
-        new->next = NULL;
-        //If list is empty
-        if(evList->head == NULL){
-            evList->head = new;
-        }
-        //Else adding to the back
-        else{
-            evList->tail->next = new;
+void lockRoomPair(RoomLock* fromMutex, Room* from, RoomLock* toMutex, Room* to, MoveStats* stats){
+    //The mutexes are not recursive, so a move into the same room takes its mutex once
+    if(fromMutex == toMutex){
+        LOCK(fromMutex);
+        stats->moves++;
+        return;
+    }
+    RoomLock* order[2] = {fromMutex, toMutex};
+    if(to->id < from->id){
+        order[0] = toMutex;
+        order[1] = fromMutex;
+    }
+    for(int i = 0; i < 2; i++){
+        if(TRYLOCK(order[i]) != 0){
+            stats->contended++;
+            LOCK(order[i]);
         }
-        evList->tail = new;
-        evList->size += 1;
-        sem_post(&(evList->evidenceMutex));
     }
+    stats->moves++;
 }
 
 /* 
-    Function: selectConnectedRoom(Room* curRoom, sem_t* mutex)
-    Purpose:  Selects a room for the given entity to move into next.
+    Function: unlockRoomPair(RoomLock* fromMutex, RoomLock* toMutex)
+    Purpose:  Unlocks the two mutexes taken by lockRoomPair, or the one mutex of a move into the same room.
     Params:   
-        Input: Room* curRoom - points to room where the entity currently is.
-        Input/Output: sem_t* mutex - points to a mutex that locks the current room while the next room is selected.
-    Return: Room* - returns a pointer to a randomly selected connected room.
+        Input/Output: RoomLock* fromMutex - points to the mutex of the room that was left.
+        Input/Output: RoomLock* toMutex - points to the mutex of the room that was entered.
+    Return: void
 */
-Room* selectConnectedRoom(Room* curRoom, sem_t* mutex){
-    Room* entering = NULL;
-    if(sem_wait(mutex) == 0){
-        //Randomly selects room from connected rooms
-        int n = randInt(0, (curRoom->connectedRooms.size));
-        RoomNode* curNode;
-        curNode = curRoom->connectedRooms.head;
-        for(int i = 0; i < n; i++){
-            curNode = curNode->next;
-        }
-        entering = curNode->data;   
-        sem_post(mutex);
+void unlockRoomPair(RoomLock* fromMutex, RoomLock* toMutex){
+    if(fromMutex == toMutex){
+        UNLOCK(fromMutex);
+        return;
     }
-    return entering;
+    UNLOCK(toMutex);
+    UNLOCK(fromMutex);
 }
\ No newline at end of file
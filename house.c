@@ -2,7 +2,7 @@
 
 /* 
     Function: populateRooms(HouseType* house)
-    Purpose:  Dynamically allocates several rooms and populates the provided house.
+    Purpose:  Allocates several rooms from the house's arena and populates the provided house.
     Params:   
         Input/Output: HouseType* house - points to the HouseType struct being populated
     Return: void
@@ -10,51 +10,95 @@
 void populateRooms(HouseType* house) {
     // First, create each room
 
-    // createRoom assumes that we dynamically allocate a room, initializes the values, and returns a RoomType*
+    // createRoom allocates a room from the game's arena, initializes the values, and returns a RoomType*
     // create functions are pretty typical, but it means errors are harder to return aside from NULL
-    struct Room* van                = createRoom("Van");
-    struct Room* hallway            = createRoom("Hallway");
-    struct Room* master_bedroom     = createRoom("Master Bedroom");
-    struct Room* boys_bedroom       = createRoom("Boy's Bedroom");
-    struct Room* bathroom           = createRoom("Bathroom");
-    struct Room* basement           = createRoom("Basement");
-    struct Room* basement_hallway   = createRoom("Basement Hallway");
-    struct Room* right_storage_room = createRoom("Right Storage Room");
-    struct Room* left_storage_room  = createRoom("Left Storage Room");
-    struct Room* kitchen            = createRoom("Kitchen");
-    struct Room* living_room        = createRoom("Living Room");
-    struct Room* garage             = createRoom("Garage");
-    struct Room* utility_room       = createRoom("Utility Room");
+    struct Room* van                = createRoom(house->arena, "Van");
+    struct Room* hallway            = createRoom(house->arena, "Hallway");
+    struct Room* master_bedroom     = createRoom(house->arena, "Master Bedroom");
+    struct Room* boys_bedroom       = createRoom(house->arena, "Boy's Bedroom");
+    struct Room* bathroom           = createRoom(house->arena, "Bathroom");
+    struct Room* basement           = createRoom(house->arena, "Basement");
+    struct Room* basement_hallway   = createRoom(house->arena, "Basement Hallway");
+    struct Room* right_storage_room = createRoom(house->arena, "Right Storage Room");
+    struct Room* left_storage_room  = createRoom(house->arena, "Left Storage Room");
+    struct Room* kitchen            = createRoom(house->arena, "Kitchen");
+    struct Room* living_room        = createRoom(house->arena, "Living Room");
+    struct Room* garage             = createRoom(house->arena, "Garage");
+    struct Room* utility_room       = createRoom(house->arena, "Utility Room");
 
     // This adds each room to each other's room lists
     // All rooms are two-way connections
-    connectRooms(van, hallway);
-    connectRooms(hallway, master_bedroom);
-    connectRooms(hallway, boys_bedroom);
-    connectRooms(hallway, bathroom);
-    connectRooms(hallway, kitchen);
-    connectRooms(hallway, basement);
-    connectRooms(basement, basement_hallway);
-    connectRooms(basement_hallway, right_storage_room);
-    connectRooms(basement_hallway, left_storage_room);
-    connectRooms(kitchen, living_room);
-    connectRooms(kitchen, garage);
-    connectRooms(garage, utility_room);
+    connectRooms(house->arena, van, hallway);
+    connectRooms(house->arena, hallway, master_bedroom);
+    connectRooms(house->arena, hallway, boys_bedroom);
+    connectRooms(house->arena, hallway, bathroom);
+    connectRooms(house->arena, hallway, kitchen);
+    connectRooms(house->arena, hallway, basement);
+    connectRooms(house->arena, basement, basement_hallway);
+    connectRooms(house->arena, basement_hallway, right_storage_room);
+    connectRooms(house->arena, basement_hallway, left_storage_room);
+    connectRooms(house->arena, kitchen, living_room);
+    connectRooms(house->arena, kitchen, garage);
+    connectRooms(house->arena, garage, utility_room);
 
     // Add each room to the house's room list
-    addRoom(&house->rooms, van);
-    addRoom(&house->rooms, hallway);
-    addRoom(&house->rooms, master_bedroom);
-    addRoom(&house->rooms, boys_bedroom);
-    addRoom(&house->rooms, bathroom);
-    addRoom(&house->rooms, basement);
-    addRoom(&house->rooms, basement_hallway);
-    addRoom(&house->rooms, right_storage_room);
-    addRoom(&house->rooms, left_storage_room);
-    addRoom(&house->rooms, kitchen);
-    addRoom(&house->rooms, living_room);
-    addRoom(&house->rooms, garage);
-    addRoom(&house->rooms, utility_room);
+    addRoom(house->arena, &house->rooms, van);
+    addRoom(house->arena, &house->rooms, hallway);
+    addRoom(house->arena, &house->rooms, master_bedroom);
+    addRoom(house->arena, &house->rooms, boys_bedroom);
+    addRoom(house->arena, &house->rooms, bathroom);
+    addRoom(house->arena, &house->rooms, basement);
+    addRoom(house->arena, &house->rooms, basement_hallway);
+    addRoom(house->arena, &house->rooms, right_storage_room);
+    addRoom(house->arena, &house->rooms, left_storage_room);
+    addRoom(house->arena, &house->rooms, kitchen);
+    addRoom(house->arena, &house->rooms, living_room);
+    addRoom(house->arena, &house->rooms, garage);
+    addRoom(house->arena, &house->rooms, utility_room);
+}
+
+/* 
+    Function: compileHouse(HouseType* house)
+    Purpose:  Compiles the rooms and connections built by populateRooms into the house's room graph.
+              Rooms are numbered in the order they were added to the house, so the Van is room 0, and every room's
+              connected rooms become one contiguous slice of the neighbour array. The linked lists used while building are
+              dropped, their nodes go back with the rest of the game's arena.
+    Params:   
+        Input/Output: HouseType* house - points to the populated house being compiled.
+    Return: void
+*/
+void compileHouse(HouseType* house){
+    RoomGraph* graph = &(house->graph);
+    graph->numRooms = house->rooms.size;
+    graph->rooms = (Room**) arenaAlloc(house->arena, sizeof(Room*) * graph->numRooms);
+    graph->offsets = (int*) arenaAlloc(house->arena, sizeof(int) * (graph->numRooms + 1));
+    //Number the rooms and count the neighbours
+    int id = 0;
+    int numNeighbours = 0;
+    for(RoomNode* curNode = house->rooms.head; curNode != NULL; curNode = curNode->next){
+        curNode->data->id = id;
+        curNode->data->graph = graph;
+        graph->rooms[id] = curNode->data;
+        graph->offsets[id] = numNeighbours;
+        numNeighbours += curNode->data->connectedRooms.size;
+        id++;
+    }
+    graph->offsets[graph->numRooms] = numNeighbours;
+    //Copy each room's connected rooms into its slice, keeping their order
+    graph->neighbours = (int*) arenaAlloc(house->arena, sizeof(int) * (numNeighbours > 0 ? numNeighbours : 1));
+    for(int i = 0; i < graph->numRooms; i++){
+        RoomList* connected = &(graph->rooms[i]->connectedRooms);
+        int next = graph->offsets[i];
+        for(RoomNode* curNode = connected->head; curNode != NULL; curNode = curNode->next){
+            graph->neighbours[next++] = curNode->data->id;
+        }
+        connected->head = NULL;
+        connected->tail = NULL;
+        connected->size = 0;
+    }
+    house->rooms.head = NULL;
+    house->rooms.tail = NULL;
+    house->rooms.size = 0;
 }
 
 /* 
@@ -68,8 +112,22 @@ void initHouse(HouseType* house){
     house->rooms.head = NULL;
     house->rooms.tail = NULL;
     house->rooms.size = 0;
-    house->sharedEvidence.head = NULL;
-    house->sharedEvidence.tail = NULL;
-    house->sharedEvidence.size = 0;
-    sem_init(&(house->sharedEvidence.evidenceMutex), 0, 1);
+    house->graph.numRooms = 0;
+    house->graph.offsets = NULL;
+    house->graph.neighbours = NULL;
+    house->graph.rooms = NULL;
+    house->graph.roomBlock = NULL;
+    //Everything the game allocates comes from the arena of the thread setting it up, and goes back to this mark
+    house->arena = gameArena();
+    house->arenaMark = arenaMark(house->arena);
+    //Setup happens at time 0, the engine takes over the clock once the game starts
+    house->now = 0;
+    clock_gettime(CLOCK_MONOTONIC, &(house->startTime));
+    house->trace = NULL;
+    house->curHunters = NULL;
+    house->numHunters = 0;
+    house->curGhosts = NULL;
+    house->numGhosts = 0;
+    atomic_init(&(house->sharedEvidence.found), 0);
+    atomic_init(&(house->sharedEvidence.size), 0);
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "defs.h"
+
+/*
+    Compiles a text house description, or a generated house, into a binary image that './finalProject --house' maps
+    and uses in place.
+*/
+int main(int argc, char* argv[])
+{
+    HouseDesc desc;
+    char* source = NULL;
+    char* output = NULL;
+    GenSpec spec;
+    int generate = C_FALSE;
+    unsigned int seed = 0;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--generate") == 0 && i + 1 < argc){
+            source = argv[++i];
+            if(parseGenSpec(source, &spec) == C_FALSE){
+                fprintf(stderr, "Bad house spec '%s', expected grid|tree|smallworld|clusters:ROOMS[:DEGREE[:uniform|power]]\n", source);
+                return 1;
+            }
+            generate = C_TRUE;
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        }
+        else if(source == NULL){
+            source = argv[i];
+        }
+        else if(output == NULL){
+            output = argv[i];
+        }
+        else{
+            source = NULL;
+            break;
+        }
+    }
+    if(source == NULL || output == NULL){
+        fprintf(stderr, "Usage: %s INPUT.house OUTPUT.img\n       %s --generate SPEC [--seed S] OUTPUT.img\n", argv[0], argv[0]);
+        return 1;
+    }
+    if(generate == C_TRUE){
+        seedRandom(seed);
+        generateHouse(&spec, &desc);
+    }
+    else if(parseHouseText(source, &desc) == C_FALSE){
+        return 1;
+    }
+    int ok = validateHouse(&desc, source) && writeHouseImage(&desc, output);
+    if(ok){
+        printf("%s: %d rooms, %d connections\n", output, desc.numRooms, desc.numNeighbours / 2);
+    }
+    freeHouseDesc(&desc);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,485 @@
+#include "defs.h"
+
+//Name -> room id lookup used while a text description is parsed, open addressing over a power of two table
+typedef struct NameTable {
+    int* slots;     //Room id + 1, 0 for an empty slot
+    int capacity;
+} NameTable;
+
+//Forward declarations
+int parseRoomLine(HouseDesc* desc, NameTable* table, char* name, long* namesCapacity, unsigned int* nameOffsetsCapacity);
+int findRoom(HouseDesc* desc, NameTable* table, char* name);
+void insertRoom(HouseDesc* desc, NameTable* table, int id);
+unsigned int hashName(char* name);
+char* trimLine(char* line);
+
+//The house every game is built from, empty until loadHouseFile succeeds
+static HouseDesc loadedHouse;
+static int houseLoaded = C_FALSE;
+
+/*
+    Function: loadHouseFile(char* path)
+    Purpose:  Loads the house every following game is built from. A compiled image (see housec) is mapped and used in
+              place, anything else is parsed as a text description. The house is checked once here, so building a game from
+              it afterwards cannot fail.
+    Params:
+        Input: char* path - stores the path of the house file.
+    Return: int - returns C_TRUE if the house was loaded, or C_FALSE otherwise
+*/
+int loadHouseFile(char* path){
+    FILE* file = fopen(path, "rb");
+    if(file == NULL){
+        fprintf(stderr, "Could not open house file '%s'\n", path);
+        return C_FALSE;
+    }
+    char magic[4] = {0};
+    int isImage = (fread(magic, 1, 4, file) == 4 && memcmp(magic, HOUSE_MAGIC, 4) == 0);
+    fclose(file);
+    HouseDesc desc;
+    if((isImage ? mapHouseImage(path, &desc) : parseHouseText(path, &desc)) == C_FALSE){
+        return C_FALSE;
+    }
+    return setLoadedHouse(&desc, path);
+}
+
+/*
+    Function: setLoadedHouse(HouseDesc* desc, char* source)
+    Purpose:  Checks a house and makes it the one every following game is built from, replacing any loaded before.
+    Params:
+        Input/Output: HouseDesc* desc - points to the house, which is taken over, or freed if it cannot be played.
+        Input: char* source - stores where the house came from, for the error message.
+    Return: int - returns C_TRUE if the house can be played, or C_FALSE otherwise
+*/
+int setLoadedHouse(HouseDesc* desc, char* source){
+    if(validateHouse(desc, source) == C_FALSE){
+        freeHouseDesc(desc);
+        return C_FALSE;
+    }
+    unloadHouseFile();
+    loadedHouse = *desc;
+    houseLoaded = C_TRUE;
+    return C_TRUE;
+}
+
+/*
+    Function: unloadHouseFile()
+    Purpose:  Releases the loaded house. Every game built from it has to have been freed.
+    Return: void
+*/
+void unloadHouseFile(){
+    if(houseLoaded == C_TRUE){
+        freeHouseDesc(&loadedHouse);
+        houseLoaded = C_FALSE;
+    }
+}
+
+/*
+    Function: buildLoadedHouse(HouseType* house)
+    Purpose:  Builds the room graph of a game from the loaded house. The offsets and neighbours are shared with the loaded
+              house, and every room lives in a single allocation, so the only per-game work is initializing the rooms.
+    Params:
+        Input/Output: HouseType* house - points to an initialized, empty house.
+    Return: int - returns C_TRUE if the graph was built, or C_FALSE if no house file is loaded
+*/
+int buildLoadedHouse(HouseType* house){
+    if(houseLoaded == C_FALSE){
+        return C_FALSE;
+    }
+    RoomGraph* graph = &(house->graph);
+    graph->numRooms = loadedHouse.numRooms;
+    graph->offsets = loadedHouse.offsets;
+    graph->neighbours = loadedHouse.neighbours;
+    graph->roomBlock = (Room*) arenaAlloc(house->arena, sizeof(Room) * graph->numRooms);
+    graph->rooms = (Room**) arenaAlloc(house->arena, sizeof(Room*) * graph->numRooms);
+    for(int i = 0; i < graph->numRooms; i++){
+        Room* room = &(graph->roomBlock[i]);
+        initRoom(room, loadedHouse.names + loadedHouse.nameOffsets[i]);
+        room->id = i;
+        room->graph = graph;
+        graph->rooms[i] = room;
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: parseHouseText(char* path, HouseDesc* desc)
+    Purpose:  Parses a text house description one line at a time. Blank lines and lines starting with '#' are skipped,
+              'room NAME' adds a room and 'connect NAME -- NAME' connects two rooms both ways. Rooms get ids in the order
+              they are listed, so the first room is the Van, and neighbours keep the order of the connect lines.
+    Params:
+        Input: char* path - stores the path of the description.
+        Output: HouseDesc* desc - points to the parsed house.
+    Return: int - returns C_TRUE if the description was parsed, or C_FALSE otherwise
+*/
+int parseHouseText(char* path, HouseDesc* desc){
+    FILE* file = fopen(path, "r");
+    if(file == NULL){
+        fprintf(stderr, "Could not open house file '%s'\n", path);
+        return C_FALSE;
+    }
+    memset(desc, 0, sizeof(HouseDesc));
+    NameTable table = {NULL, 0};
+    long namesCapacity = 0;
+    unsigned int nameOffsetsCapacity = 0;
+    long edgesCapacity = 1024, numEdges = 0;
+    int* edges = (int*) malloc(sizeof(int) * 2 * edgesCapacity);
+    char line[HOUSE_LINE_MAX];
+    int lineNumber = 0;
+    int ok = C_TRUE;
+    while(ok == C_TRUE && fgets(line, sizeof(line), file) != NULL){
+        lineNumber++;
+        if(strchr(line, '\n') == NULL && !feof(file)){
+            fprintf(stderr, "%s:%d: line is longer than %d characters\n", path, lineNumber, HOUSE_LINE_MAX - 2);
+            ok = C_FALSE;
+            break;
+        }
+        char* text = trimLine(line);
+        if(text[0] == '\0' || text[0] == '#'){
+            continue;
+        }
+        if(strncmp(text, "room ", 5) == 0){
+            char* name = trimLine(text + 5);
+            if(parseRoomLine(desc, &table, name, &namesCapacity, &nameOffsetsCapacity) == C_FALSE){
+                fprintf(stderr, "%s:%d: room name '%s' is empty, too long or already used\n", path, lineNumber, name);
+                ok = C_FALSE;
+            }
+        }
+        else if(strncmp(text, "connect ", 8) == 0){
+            char* split = strstr(text + 8, " -- ");
+            if(split == NULL){
+                fprintf(stderr, "%s:%d: expected 'connect NAME -- NAME'\n", path, lineNumber);
+                ok = C_FALSE;
+                break;
+            }
+            *split = '\0';
+            char* first = trimLine(text + 8);
+            char* second = trimLine(split + 4);
+            int a = findRoom(desc, &table, first);
+            int b = findRoom(desc, &table, second);
+            if(a < 0 || b < 0){
+                fprintf(stderr, "%s:%d: unknown room '%s'\n", path, lineNumber, (a < 0) ? first : second);
+                ok = C_FALSE;
+                break;
+            }
+            if(a == b){
+                fprintf(stderr, "%s:%d: room '%s' cannot be connected to itself\n", path, lineNumber, first);
+                ok = C_FALSE;
+                break;
+            }
+            if(numEdges == edgesCapacity){
+                edgesCapacity *= 2;
+                edges = (int*) realloc(edges, sizeof(int) * 2 * edgesCapacity);
+            }
+            edges[2 * numEdges] = a;
+            edges[2 * numEdges + 1] = b;
+            numEdges++;
+        }
+        else{
+            fprintf(stderr, "%s:%d: expected 'room NAME' or 'connect NAME -- NAME'\n", path, lineNumber);
+            ok = C_FALSE;
+        }
+    }
+    fclose(file);
+    free(table.slots);
+    if(ok == C_TRUE){
+        buildNeighbours(desc, edges, numEdges);
+    }
+    free(edges);
+    if(ok == C_FALSE){
+        freeHouseDesc(desc);
+    }
+    return ok;
+}
+
+/*
+    Function: parseRoomLine(HouseDesc* desc, NameTable* table, char* name, long* namesCapacity, unsigned int* nameOffsetsCapacity)
+    Purpose:  Adds a room to a house being parsed, interning its name.
+    Params:
+        Input/Output: HouseDesc* desc - points to the house being parsed.
+        Input/Output: NameTable* table - points to the name lookup.
+        Input: char* name - stores the name of the room.
+        Input/Output: long* namesCapacity - stores the capacity of the name pool.
+        Input/Output: unsigned int* nameOffsetsCapacity - stores the capacity of the name offsets.
+    Return: int - returns C_TRUE if the room was added, or C_FALSE if its name is empty, too long or already used
+*/
+int parseRoomLine(HouseDesc* desc, NameTable* table, char* name, long* namesCapacity, unsigned int* nameOffsetsCapacity){
+    long length = strlen(name);
+    if(length == 0 || length >= MAX_STR || findRoom(desc, table, name) >= 0){
+        return C_FALSE;
+    }
+    if(desc->namesSize + length + 1 > *namesCapacity){
+        *namesCapacity = (*namesCapacity > 0) ? *namesCapacity * 2 : 4096;
+        desc->names = (char*) realloc(desc->names, *namesCapacity);
+    }
+    if((unsigned int) desc->numRooms == *nameOffsetsCapacity){
+        *nameOffsetsCapacity = (*nameOffsetsCapacity > 0) ? *nameOffsetsCapacity * 2 : 256;
+        desc->nameOffsets = (unsigned int*) realloc(desc->nameOffsets, sizeof(unsigned int) * *nameOffsetsCapacity);
+    }
+    desc->nameOffsets[desc->numRooms] = (unsigned int) desc->namesSize;
+    memcpy(desc->names + desc->namesSize, name, length + 1);
+    desc->namesSize += length + 1;
+    insertRoom(desc, table, desc->numRooms);
+    desc->numRooms++;
+    return C_TRUE;
+}
+
+/*
+    Function: buildNeighbours(HouseDesc* desc, int* edges, long numEdges)
+    Purpose:  Turns the parsed connections into the offsets and neighbours arrays with a counting pass and a fill pass.
+              Each connection adds both directions in turn, so every room lists its neighbours in the same order
+              connectRooms would have built them.
+    Params:
+        Input/Output: HouseDesc* desc - points to the parsed house, its rooms are all known.
+        Input: int* edges - stores the connections as pairs of room ids.
+        Input: long numEdges - stores the number of connections.
+    Return: void
+*/
+void buildNeighbours(HouseDesc* desc, int* edges, long numEdges){
+    desc->numNeighbours = (int) (2 * numEdges);
+    desc->offsets = (int*) calloc(desc->numRooms + 1, sizeof(int));
+    desc->neighbours = (int*) malloc(sizeof(int) * (desc->numNeighbours > 0 ? desc->numNeighbours : 1));
+    for(long i = 0; i < 2 * numEdges; i++){
+        desc->offsets[edges[i] + 1]++;
+    }
+    for(int i = 0; i < desc->numRooms; i++){
+        desc->offsets[i + 1] += desc->offsets[i];
+    }
+    int* next = (int*) malloc(sizeof(int) * (desc->numRooms > 0 ? desc->numRooms : 1));
+    memcpy(next, desc->offsets, sizeof(int) * desc->numRooms);
+    for(long i = 0; i < numEdges; i++){
+        int a = edges[2 * i], b = edges[2 * i + 1];
+        desc->neighbours[next[a]++] = b;
+        desc->neighbours[next[b]++] = a;
+    }
+    free(next);
+}
+
+/*
+    Function: findRoom(HouseDesc* desc, NameTable* table, char* name)
+    Purpose:  Looks up a room of a house being parsed by name.
+    Params:
+        Input: HouseDesc* desc - points to the house being parsed.
+        Input: NameTable* table - points to the name lookup.
+        Input: char* name - stores the name being looked up.
+    Return: int - returns the id of the room, or -1 if there is no room with that name
+*/
+int findRoom(HouseDesc* desc, NameTable* table, char* name){
+    if(table->capacity == 0){
+        return -1;
+    }
+    unsigned int slot = hashName(name) & (table->capacity - 1);
+    while(table->slots[slot] != 0){
+        int id = table->slots[slot] - 1;
+        if(strcmp(desc->names + desc->nameOffsets[id], name) == 0){
+            return id;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    return -1;
+}
+
+/*
+    Function: insertRoom(HouseDesc* desc, NameTable* table, int id)
+    Purpose:  Adds a room to the name lookup, doubling the table whenever it gets half full.
+    Params:
+        Input: HouseDesc* desc - points to the house being parsed, the room's name is already interned.
+        Input/Output: NameTable* table - points to the name lookup.
+        Input: int id - stores the id of the room.
+    Return: void
+*/
+void insertRoom(HouseDesc* desc, NameTable* table, int id){
+    if(2 * (id + 1) > table->capacity){
+        int oldCapacity = table->capacity;
+        int* oldSlots = table->slots;
+        table->capacity = (oldCapacity > 0) ? oldCapacity * 2 : 1024;
+        table->slots = (int*) calloc(table->capacity, sizeof(int));
+        for(int i = 0; i < oldCapacity; i++){
+            if(oldSlots[i] != 0){
+                unsigned int slot = hashName(desc->names + desc->nameOffsets[oldSlots[i] - 1]) & (table->capacity - 1);
+                while(table->slots[slot] != 0){
+                    slot = (slot + 1) & (table->capacity - 1);
+                }
+                table->slots[slot] = oldSlots[i];
+            }
+        }
+        free(oldSlots);
+    }
+    unsigned int slot = hashName(desc->names + desc->nameOffsets[id]) & (table->capacity - 1);
+    while(table->slots[slot] != 0){
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->slots[slot] = id + 1;
+}
+
+/*
+    Function: hashName(char* name)
+    Purpose:  Hashes a room name with FNV-1a.
+    Params:
+        Input: char* name - stores the name.
+    Return: unsigned int - returns the hash.
+*/
+unsigned int hashName(char* name){
+    unsigned int hash = 2166136261u;
+    for(unsigned char* c = (unsigned char*) name; *c != '\0'; c++){
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+    Function: trimLine(char* line)
+    Purpose:  Strips the leading and trailing whitespace, including the newline, from a line in place.
+    Params:
+        Input/Output: char* line - stores the line.
+    Return: char* - returns a pointer to the first non-whitespace character.
+*/
+char* trimLine(char* line){
+    while(*line == ' ' || *line == '\t'){
+        line++;
+    }
+    long length = strlen(line);
+    while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t')){
+        line[--length] = '\0';
+    }
+    return line;
+}
+
+/*
+    Function: mapHouseImage(char* path, HouseDesc* desc)
+    Purpose:  Maps a compiled house image read-only. The arrays of the house point straight into the mapping,
+              so nothing is parsed or copied and pages are only read in when a game touches them.
+    Params:
+        Input: char* path - stores the path of the image.
+        Output: HouseDesc* desc - points to the mapped house.
+    Return: int - returns C_TRUE if the image was mapped, or C_FALSE otherwise
+*/
+int mapHouseImage(char* path, HouseDesc* desc){
+    memset(desc, 0, sizeof(HouseDesc));
+    FILE* file = fopen(path, "rb");
+    if(file == NULL){
+        fprintf(stderr, "Could not open house file '%s'\n", path);
+        return C_FALSE;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    void* image = (size >= (long) sizeof(HouseImageHeader)) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0) : MAP_FAILED;
+    fclose(file);
+    if(image == MAP_FAILED){
+        fprintf(stderr, "Could not map house image '%s'\n", path);
+        return C_FALSE;
+    }
+    HouseImageHeader* header = (HouseImageHeader*) image;
+    long expected = sizeof(HouseImageHeader) + sizeof(int) * ((long) header->numRooms + 1 + header->numNeighbours)
+                    + sizeof(unsigned int) * (long) header->numRooms + header->namesSize;
+    if(header->version != HOUSE_VERSION || header->numRooms > INT32_MAX - 1 || header->numNeighbours > INT32_MAX || expected != size){
+        fprintf(stderr, "'%s' is not a valid house image for this version\n", path);
+        munmap(image, size);
+        return C_FALSE;
+    }
+    desc->numRooms = (int) header->numRooms;
+    desc->numNeighbours = (int) header->numNeighbours;
+    desc->offsets = (int*) (header + 1);
+    desc->neighbours = desc->offsets + desc->numRooms + 1;
+    desc->nameOffsets = (unsigned int*) (desc->neighbours + desc->numNeighbours);
+    desc->names = (char*) (desc->nameOffsets + desc->numRooms);
+    desc->namesSize = header->namesSize;
+    desc->image = image;
+    desc->imageSize = size;
+    return C_TRUE;
+}
+
+/*
+    Function: writeHouseImage(HouseDesc* desc, char* path)
+    Purpose:  Writes a house as a compiled image that mapHouseImage can use in place.
+    Params:
+        Input: HouseDesc* desc - points to the house.
+        Input: char* path - stores the path of the image.
+    Return: int - returns C_TRUE if the image was written, or C_FALSE otherwise
+*/
+int writeHouseImage(HouseDesc* desc, char* path){
+    FILE* file = fopen(path, "wb");
+    if(file == NULL){
+        fprintf(stderr, "Could not create house image '%s'\n", path);
+        return C_FALSE;
+    }
+    HouseImageHeader header;
+    memcpy(header.magic, HOUSE_MAGIC, 4);
+    header.version = HOUSE_VERSION;
+    header.numRooms = desc->numRooms;
+    header.numNeighbours = desc->numNeighbours;
+    header.namesSize = (uint32_t) desc->namesSize;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1
+             && fwrite(desc->offsets, sizeof(int), desc->numRooms + 1, file) == (size_t) desc->numRooms + 1
+             && fwrite(desc->neighbours, sizeof(int), desc->numNeighbours, file) == (size_t) desc->numNeighbours
+             && fwrite(desc->nameOffsets, sizeof(unsigned int), desc->numRooms, file) == (size_t) desc->numRooms
+             && fwrite(desc->names, 1, desc->namesSize, file) == (size_t) desc->namesSize;
+    if(fclose(file) != 0 || !ok){
+        fprintf(stderr, "Could not write house image '%s'\n", path);
+        return C_FALSE;
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: validateHouse(HouseDesc* desc, char* path)
+    Purpose:  Checks that a house can be played: at least the Van and one other room, well formed neighbour slices
+              with every room connected to something other than itself, and names that fit a Room.
+    Params:
+        Input: HouseDesc* desc - points to the house.
+        Input: char* path - stores the path of the house file, for the error message.
+    Return: int - returns C_TRUE if the house can be played, or C_FALSE otherwise
+*/
+int validateHouse(HouseDesc* desc, char* path){
+    if(desc->numRooms < 2){
+        fprintf(stderr, "'%s' needs the Van and at least one other room\n", path);
+        return C_FALSE;
+    }
+    if(desc->offsets[0] != 0 || desc->offsets[desc->numRooms] != desc->numNeighbours){
+        fprintf(stderr, "'%s' has a malformed room graph\n", path);
+        return C_FALSE;
+    }
+    for(int i = 0; i < desc->numRooms; i++){
+        if(desc->offsets[i + 1] <= desc->offsets[i]){
+            fprintf(stderr, "'%s': room %d is not connected to any other room\n", path, i);
+            return C_FALSE;
+        }
+        if(desc->nameOffsets[i] >= desc->namesSize || memchr(desc->names + desc->nameOffsets[i], '\0', desc->namesSize - desc->nameOffsets[i]) == NULL
+           || strlen(desc->names + desc->nameOffsets[i]) >= MAX_STR){
+            fprintf(stderr, "'%s': room %d has a malformed name\n", path, i);
+            return C_FALSE;
+        }
+        for(int j = desc->offsets[i]; j < desc->offsets[i + 1]; j++){
+            if(desc->neighbours[j] == i){
+                fprintf(stderr, "'%s': room %d is connected to itself\n", path, i);
+                return C_FALSE;
+            }
+        }
+    }
+    for(int i = 0; i < desc->numNeighbours; i++){
+        if(desc->neighbours[i] < 0 || desc->neighbours[i] >= desc->numRooms){
+            fprintf(stderr, "'%s' has a malformed room graph\n", path);
+            return C_FALSE;
+        }
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: freeHouseDesc(HouseDesc* desc)
+    Purpose:  Frees a parsed house, or unmaps a compiled image.
+    Params:
+        Input/Output: HouseDesc* desc - points to the house.
+    Return: void
+*/
+void freeHouseDesc(HouseDesc* desc){
+    if(desc->image != NULL){
+        munmap(desc->image, desc->imageSize);
+    }
+    else{
+        free(desc->offsets);
+        free(desc->neighbours);
+        free(desc->nameOffsets);
+        free(desc->names);
+    }
+    memset(desc, 0, sizeof(HouseDesc));
+}
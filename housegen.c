@@ -0,0 +1,331 @@
+#include "defs.h"
+
+//Connections of a house being generated, as pairs of room ids
+typedef struct EdgeList {
+    int* pairs;
+    long size;
+    long capacity;
+} EdgeList;
+
+//Forward declarations
+void addEdge(EdgeList* edges, int a, int b);
+int pickRoom(Rng* rng, EdgeList* edges, int limit, GenDistribution distribution);
+void addShortcuts(Rng* rng, EdgeList* edges, int numRooms, int degree, GenDistribution distribution);
+void generateGrid(Rng* rng, EdgeList* edges, GenSpec* spec, int* columns);
+void generateTree(Rng* rng, EdgeList* edges, GenSpec* spec);
+void generateSmallWorld(Rng* rng, EdgeList* edges, GenSpec* spec);
+void generateClusters(Rng* rng, EdgeList* edges, GenSpec* spec);
+void nameRooms(HouseDesc* desc, GenSpec* spec, int van, int columns);
+
+/*
+    Function: parseGenSpec(char* text, GenSpec* spec)
+    Purpose:  Reads a generator spec of the form TOPOLOGY:ROOMS[:DEGREE[:DISTRIBUTION]], for example 'grid:1e6' or
+              'smallworld:100000:6:power'. The topology is grid, tree, smallworld or clusters, DEGREE is the mean number of
+              connections per room and DISTRIBUTION is uniform or power.
+    Params:
+        Input: char* text - stores the spec.
+        Output: GenSpec* spec - points to the parsed spec.
+    Return: int - returns C_TRUE if the spec is valid, or C_FALSE otherwise
+*/
+int parseGenSpec(char* text, GenSpec* spec){
+    char copy[MAX_STR];
+    if(strlen(text) >= MAX_STR){
+        return C_FALSE;
+    }
+    strcpy(copy, text);
+    char* fields[4] = {NULL, NULL, NULL, NULL};
+    int numFields = 0;
+    for(char* field = strtok(copy, ":"); field != NULL && numFields < 4; field = strtok(NULL, ":")){
+        fields[numFields++] = field;
+    }
+    if(numFields < 2){
+        return C_FALSE;
+    }
+    if(strcmp(fields[0], "grid") == 0){
+        spec->topology = GEN_GRID;
+        spec->degree = 4;
+    }
+    else if(strcmp(fields[0], "tree") == 0){
+        spec->topology = GEN_TREE;
+        spec->degree = 2;
+    }
+    else if(strcmp(fields[0], "smallworld") == 0){
+        spec->topology = GEN_SMALL_WORLD;
+        spec->degree = 4;
+    }
+    else if(strcmp(fields[0], "clusters") == 0){
+        spec->topology = GEN_CLUSTERS;
+        spec->degree = 8;
+    }
+    else{
+        return C_FALSE;
+    }
+    double rooms = strtod(fields[1], NULL);
+    if(rooms < 2 || rooms > GEN_MAX_ROOMS){
+        return C_FALSE;
+    }
+    spec->rooms = (int) rooms;
+    if(numFields > 2){
+        spec->degree = atoi(fields[2]);
+    }
+    if(spec->degree < 1 || spec->degree > GEN_MAX_DEGREE || (long) spec->rooms * spec->degree > INT32_MAX){
+        return C_FALSE;
+    }
+    spec->distribution = GEN_UNIFORM;
+    if(numFields > 3){
+        if(strcmp(fields[3], "power") == 0){
+            spec->distribution = GEN_POWER;
+        }
+        else if(strcmp(fields[3], "uniform") != 0){
+            return C_FALSE;
+        }
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: generateHouse(GenSpec* spec, HouseDesc* desc)
+    Purpose:  Generates a connected house from the current base seed. The Van is a room picked from the seed and
+              swapped into id 0, so the same seed always gives the same house with the same start room.
+    Params:
+        Input: GenSpec* spec - stores the topology, the number of rooms and the degree distribution.
+        Output: HouseDesc* desc - points to the generated house, ready for setLoadedHouse or writeHouseImage.
+    Return: void
+*/
+void generateHouse(GenSpec* spec, HouseDesc* desc){
+    Rng rng;
+    rngInit(&rng, RNG_RUN_GENERATOR, RNG_STREAM_HOUSE);
+    EdgeList edges = {NULL, 0, 0};
+    int columns = 0;
+    switch(spec->topology){
+        case GEN_GRID:
+            generateGrid(&rng, &edges, spec, &columns);
+            break;
+        case GEN_TREE:
+            generateTree(&rng, &edges, spec);
+            break;
+        case GEN_SMALL_WORLD:
+            generateSmallWorld(&rng, &edges, spec);
+            break;
+        case GEN_CLUSTERS:
+            generateClusters(&rng, &edges, spec);
+            break;
+    }
+    //Swap the seeded Van into room 0
+    int van = (int) rngBelow(&rng, spec->rooms);
+    for(long i = 0; i < 2 * edges.size; i++){
+        if(edges.pairs[i] == van){
+            edges.pairs[i] = 0;
+        }
+        else if(edges.pairs[i] == 0){
+            edges.pairs[i] = van;
+        }
+    }
+    memset(desc, 0, sizeof(HouseDesc));
+    desc->numRooms = spec->rooms;
+    nameRooms(desc, spec, van, columns);
+    buildNeighbours(desc, edges.pairs, edges.size);
+    free(edges.pairs);
+}
+
+/*
+    Function: generateGrid(Rng* rng, EdgeList* edges, GenSpec* spec, int* columns)
+    Purpose:  Lays the rooms out row by row on a square-ish grid and connects each one to the rooms beside it.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Output: EdgeList* edges - points to the connections.
+        Input: GenSpec* spec - stores the number of rooms and the mean degree, grids above 4 get random shortcuts.
+        Output: int* columns - stores the width of the grid, used to name the rooms.
+    Return: void
+*/
+void generateGrid(Rng* rng, EdgeList* edges, GenSpec* spec, int* columns){
+    int width = 1;
+    while((long) width * width < spec->rooms){
+        width++;
+    }
+    *columns = width;
+    for(int i = 0; i < spec->rooms; i++){
+        if(i % width != 0){
+            addEdge(edges, i - 1, i);
+        }
+        if(i >= width){
+            addEdge(edges, i - width, i);
+        }
+    }
+    addShortcuts(rng, edges, spec->rooms, spec->degree, spec->distribution);
+}
+
+/*
+    Function: generateTree(Rng* rng, EdgeList* edges, GenSpec* spec)
+    Purpose:  Grows a random tree, attaching every room to an earlier one. A uniform distribution gives a random
+              recursive tree, a power distribution favours rooms that already have many connections.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Output: EdgeList* edges - points to the connections.
+        Input: GenSpec* spec - stores the number of rooms and the degree distribution, degrees above 2 get random shortcuts.
+    Return: void
+*/
+void generateTree(Rng* rng, EdgeList* edges, GenSpec* spec){
+    for(int i = 1; i < spec->rooms; i++){
+        addEdge(edges, pickRoom(rng, edges, i, spec->distribution), i);
+    }
+    addShortcuts(rng, edges, spec->rooms, spec->degree, spec->distribution);
+}
+
+/*
+    Function: generateSmallWorld(Rng* rng, EdgeList* edges, GenSpec* spec)
+    Purpose:  Builds a Watts-Strogatz house: a ring where every room is connected to its degree/2 nearest rooms on each side,
+              after which one in GEN_REWIRE_ONE_IN of the longer ring connections is moved to a random room. The connections
+              to the next room are never moved, so the house stays connected. An odd degree, and any rewired connection that
+              landed back on its own room, is made up with random shortcuts.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Output: EdgeList* edges - points to the connections.
+        Input: GenSpec* spec - stores the number of rooms, the degree and the distribution of rewired connections.
+    Return: void
+*/
+void generateSmallWorld(Rng* rng, EdgeList* edges, GenSpec* spec){
+    int reach = (spec->degree >= 2) ? spec->degree / 2 : 1;
+    if(reach > (spec->rooms - 1) / 2){
+        reach = (spec->rooms - 1) / 2;
+    }
+    if(reach < 1){
+        reach = 1;
+    }
+    for(int i = 0; i < spec->rooms; i++){
+        for(int step = 1; step <= reach; step++){
+            int other = (i + step) % spec->rooms;
+            if(step > 1 && rngBelow(rng, GEN_REWIRE_ONE_IN) == 0){
+                other = pickRoom(rng, edges, spec->rooms, spec->distribution);
+            }
+            if(other != i){
+                addEdge(edges, i, other);
+            }
+        }
+    }
+    addShortcuts(rng, edges, spec->rooms, spec->degree, spec->distribution);
+}
+
+/*
+    Function: generateClusters(Rng* rng, EdgeList* edges, GenSpec* spec)
+    Purpose:  Splits the rooms into clusters of degree + 1 rooms that are all connected to each other, then joins each
+              cluster to an earlier one through a single connection between random members.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Output: EdgeList* edges - points to the connections.
+        Input: GenSpec* spec - stores the number of rooms, the degree and the distribution used to pick the cluster joined to.
+    Return: void
+*/
+void generateClusters(Rng* rng, EdgeList* edges, GenSpec* spec){
+    int size = spec->degree + 1;
+    for(int first = 0; first < spec->rooms; first += size){
+        int last = (first + size < spec->rooms) ? first + size : spec->rooms;
+        for(int a = first; a < last; a++){
+            for(int b = a + 1; b < last; b++){
+                addEdge(edges, a, b);
+            }
+        }
+        if(first > 0){
+            //Rooms of earlier clusters picked by the distribution, so big hubs form with a power distribution
+            int other = pickRoom(rng, edges, first, spec->distribution);
+            addEdge(edges, other, first + (int) rngBelow(rng, last - first));
+        }
+    }
+}
+
+/*
+    Function: addShortcuts(Rng* rng, EdgeList* edges, int numRooms, int degree, GenDistribution distribution)
+    Purpose:  Adds random connections until the mean number of connections per room reaches the requested degree.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Input/Output: EdgeList* edges - points to the connections.
+        Input: int numRooms - stores the number of rooms.
+        Input: int degree - stores the mean number of connections per room.
+        Input: GenDistribution distribution - stores how the rooms at each end of a shortcut are picked.
+    Return: void
+*/
+void addShortcuts(Rng* rng, EdgeList* edges, int numRooms, int degree, GenDistribution distribution){
+    long target = (long) numRooms * degree / 2;
+    while(edges->size < target){
+        int a = (int) rngBelow(rng, numRooms);
+        int b = pickRoom(rng, edges, numRooms, distribution);
+        if(a != b){
+            addEdge(edges, a, b);
+        }
+    }
+}
+
+/*
+    Function: pickRoom(Rng* rng, EdgeList* edges, int limit, GenDistribution distribution)
+    Purpose:  Picks a random room below limit. With a power distribution the end of a random existing connection is
+              picked instead, so rooms are picked in proportion to their connections and degrees follow a power law.
+    Params:
+        Input/Output: Rng* rng - points to the generator's stream.
+        Input: EdgeList* edges - points to the connections so far, all between rooms below limit.
+        Input: int limit - stores the number of rooms that can be picked.
+        Input: GenDistribution distribution - stores how the room is picked.
+    Return: int - returns the id of the room.
+*/
+int pickRoom(Rng* rng, EdgeList* edges, int limit, GenDistribution distribution){
+    if(distribution == GEN_POWER && edges->size > 0){
+        int room = edges->pairs[rngBelow(rng, (uint32_t) (2 * edges->size))];
+        if(room < limit){
+            return room;
+        }
+    }
+    return (int) rngBelow(rng, limit);
+}
+
+/*
+    Function: addEdge(EdgeList* edges, int a, int b)
+    Purpose:  Appends a connection between two rooms.
+    Params:
+        Input/Output: EdgeList* edges - points to the connections.
+        Input: int a - stores the id of the first room.
+        Input: int b - stores the id of the second room.
+    Return: void
+*/
+void addEdge(EdgeList* edges, int a, int b){
+    if(edges->size == edges->capacity){
+        edges->capacity = (edges->capacity > 0) ? edges->capacity * 2 : 1024;
+        edges->pairs = (int*) realloc(edges->pairs, sizeof(int) * 2 * edges->capacity);
+    }
+    edges->pairs[2 * edges->size] = a;
+    edges->pairs[2 * edges->size + 1] = b;
+    edges->size++;
+}
+
+/*
+    Function: nameRooms(HouseDesc* desc, GenSpec* spec, int van, int columns)
+    Purpose:  Interns a name for every room: 'Van' for room 0, and otherwise the room's place in the generated layout,
+              'Room ROW,COLUMN' on a grid and 'Room N' elsewhere.
+    Params:
+        Input/Output: HouseDesc* desc - points to the house, its number of rooms is set.
+        Input: GenSpec* spec - stores the topology.
+        Input: int van - stores the generated room that was swapped into room 0.
+        Input: int columns - stores the width of a grid.
+    Return: void
+*/
+void nameRooms(HouseDesc* desc, GenSpec* spec, int van, int columns){
+    long capacity = (long) desc->numRooms * 16;
+    desc->names = (char*) malloc(capacity);
+    desc->nameOffsets = (unsigned int*) malloc(sizeof(unsigned int) * desc->numRooms);
+    desc->namesSize = 0;
+    for(int i = 0; i < desc->numRooms; i++){
+        //Room 0 and the Van's generated room traded places
+        int node = (i == 0) ? van : (i == van) ? 0 : i;
+        char* name = desc->names + desc->namesSize;
+        int length;
+        if(i == 0){
+            length = sprintf(name, "Van");
+        }
+        else if(spec->topology == GEN_GRID){
+            length = sprintf(name, "Room %d,%d", node / columns, node % columns);
+        }
+        else{
+            length = sprintf(name, "Room %d", node);
+        }
+        desc->nameOffsets[i] = (unsigned int) desc->namesSize;
+        desc->namesSize += length + 1;
+    }
+}
@@ -2,84 +2,129 @@
 
 //Function declarations
 void moveHunter(Hunter* hunter);
-int removeEvidence(Hunter* hunter);
-void removeHunter(Hunter* hunter);
-void addHunter(Hunter* hunter, Room* entering);
-int isGhostInRoom(Room* curRoom);
 int isHunterleaving(Hunter* curHunter);
 void collectEvidence(Hunter* hunter);
 int reviewEvidence(Hunter* hunter);
 
 /* 
-    Function: initHunter(char* name, Room* startingRoom, EvidenceType equipment, EvidenceList* sharedEvidence)
-    Purpose:  Initializes a Hunter struct.
+    Function: initHunter(HouseType* house, int id, char* name, EvidenceType equipment)
+    Purpose:  Initializes a Hunter struct. The hunter starts in the Van and shares the house's evidence.
+              It is linked into the Van's hunters with linkHunter once it has its final address.
     Params:   
+        Input: HouseType* house - points to the house the hunter is hunting in.
+        Input: int id - stores the hunter's index in the house.
         Input: char* name - stores the name of the hunter being initialized.
-        Input: Room* startingRoom - points to the room the hunter will start in (Van).
         Input: EvidenceType equipment - stores the type of evidence the hunter will be able to read.
-        Input: EvidenceList* sharedEvidence - points the EvidenceList shared by all hunters.
     Return: Hunter - returns a fully initialized hunter.
 */
-Hunter initHunter(char* name, Room* startingRoom, EvidenceType equipment, EvidenceList* sharedEvidence){
+Hunter initHunter(HouseType* house, int id, char* name, EvidenceType equipment){
     Hunter new;
-    new.curRoom = startingRoom;
+    new.curRoom = house->graph.rooms[0];
+    new.prevInRoom = NULL;
+    new.nextInRoom = NULL;
+    new.moveStats.moves = 0;
+    new.moveStats.contended = 0;
     new.reader = equipment;
     strcpy(new.hunterName, name);
-    new.sharedEvidencePointer = sharedEvidence;
+    new.sharedEvidencePointer = &(house->sharedEvidence);
     new.fear = 0;
     new.boredom = 0;
-    l_hunterInit(name, equipment);
+    new.id = id;
+    new.house = house;
+    rngInit(&(new.rng), house->runId, RNG_STREAM_HUNTER + id);
+    l_hunterInit(&new);
     return new;
 }
 
 /* 
     Function: runHunter(void* voidHunter)
-    Purpose:  Runs the hunter thread. 
+    Purpose:  Runs the hunter thread. The hunter stops taking turns once it leaves or the game is decided.
     Params:   
         Input/Output: void* voidHunter - points to the Hunter that is going to run in the thread.
     Return: void*
 */
 void* runHunter(void* voidHunter){
     Hunter* curHunter = (Hunter*) voidHunter;
-    //Loops the hunter so it keeps taking actions
-    while(C_TRUE){
-        usleep(HUNTER_WAIT);
-        //Checks if the hunter is leaving due to either fear or boredom, and ends the loop if so
-        if(isHunterleaving(curHunter) == C_TRUE){
+    rngUse(&(curHunter->rng));
+    int leaving = C_FALSE;
+    //Loops the hunter so it keeps taking actions, the wait ends early when the game does
+    while(gameSleep(curHunter->house, HUNTER_WAIT) == C_FALSE){
+        if(hunterStep(curHunter) == C_TRUE){
+            leaving = C_TRUE;
             break;
         }
-        //randomly chooses an action and then performs it
-        int hunterChoice = randInt(0, 3);
-        if(hunterChoice == 0){
-            collectEvidence(curHunter);
-        }
-        else if(hunterChoice == 1){
-            moveHunter(curHunter);
-        }
-        else{
-            if(reviewEvidence(curHunter) == C_TRUE){
-                l_hunterExit(curHunter->hunterName, LOG_EVIDENCE);
-                break;
-            }
-        }
     }
     //removes the hunter from whatever room it's in when the hunter leaves
     removeHunter(curHunter);
+    if(leaving == C_TRUE){
+        hunterLeft(curHunter->house, curHunter);
+    }
     return NULL;
 }
 
+/* 
+    Function: hunterStep(Hunter* curHunter)
+    Purpose:  Performs one turn of a hunter. Shared by the threaded and the virtual time engines.
+    Params:   
+        Input/Output: Hunter* curHunter - points to the Hunter taking its turn.
+    Return: int - returns C_TRUE if the hunter left the house this turn, or C_FALSE otherwise
+*/
+int hunterStep(Hunter* curHunter){
+    //Checks if the hunter is leaving due to either fear or boredom
+    int leaving;
+    INSTR_TIME(FN_HUNTER_LEAVING, leaving = isHunterleaving(curHunter));
+    if(leaving == C_TRUE){
+        return C_TRUE;
+    }
+    return hunterAct(curHunter);
+}
+
+/* 
+    Function: hunterAct(Hunter* curHunter)
+    Purpose:  Performs the action part of a hunter's turn, once it is known the hunter is staying. The tick engine calls it
+              directly after checking fear and boredom for every hunter at once.
+    Params:   
+        Input/Output: Hunter* curHunter - points to the Hunter taking its turn.
+    Return: int - returns C_TRUE if the hunter left the house with sufficient evidence, or C_FALSE otherwise
+*/
+int hunterAct(Hunter* curHunter){
+    //randomly chooses an action and then performs it
+    int hunterChoice = randInt(0, 3);
+    if(hunterChoice == 0){
+        INSTR_TIME(FN_COLLECT_EVIDENCE, collectEvidence(curHunter));
+    }
+    else if(hunterChoice == 1){
+        INSTR_TIME(FN_MOVE_HUNTER, moveHunter(curHunter));
+    }
+    else{
+        int sufficient;
+        INSTR_TIME(FN_REVIEW_EVIDENCE, sufficient = reviewEvidence(curHunter));
+        if(sufficient == C_TRUE){
+            l_hunterExit(curHunter, LOG_EVIDENCE);
+            return C_TRUE;
+        }
+    }
+    return C_FALSE;
+}
+
 /* 
     Function: moveHunter(Hunter* hunter)
-    Purpose:  Moves a hunter from one room to another randomly selected room.
+    Purpose:  Moves a hunter from one room to another randomly selected room. Both rooms are locked for the whole move,
+              so the hunter is always in exactly one room's list.
     Params:   
         Input/Output: Hunter* hunter - points to the Hunter moving room.
     Return: void
 */
 void moveHunter(Hunter* hunter){
     //Selects the room to move to
-    Room* entering = selectConnectedRoom(hunter->curRoom, &(hunter->curRoom->roomHunterMutex));
-    removeHunter(hunter);
-    addHunter(hunter, entering);
+    Room* leaving = hunter->curRoom;
+    Room* entering = selectConnectedRoom(leaving);
+    lockRoomPair(&(leaving->roomHunterMutex), leaving, &(entering->roomHunterMutex), entering, &(hunter->moveStats));
+    unlinkHunter(leaving, hunter);
+    linkHunter(entering, hunter);
+    hunter->curRoom = entering;
+    l_hunterMove(hunter, entering);
+    unlockRoomPair(&(leaving->roomHunterMutex), &(entering->roomHunterMutex));
 }
 
 /* 
@@ -90,39 +135,58 @@ void moveHunter(Hunter* hunter){
     Return: void
 */
 void removeHunter(Hunter* hunter){
-    if(sem_wait(&(hunter->curRoom->roomHunterMutex)) == 0){
-        //Remove hunter from leaving room
-        for(int i = 0; i < NUM_HUNTERS; i++){
-            if(hunter->curRoom->curHunters[i] == hunter){
-                hunter->curRoom->curHunters[i] = NULL;
-                break;
-            }
-        }
-        sem_post(&(hunter->curRoom->roomHunterMutex));
+    LOCK(&(hunter->curRoom->roomHunterMutex));
+    //Remove hunter from leaving room
+    unlinkHunter(hunter->curRoom, hunter);
+    UNLOCK(&(hunter->curRoom->roomHunterMutex));
+}
+
+/* 
+    Function: linkHunter(Room* room, Hunter* hunter)
+    Purpose:  Pushes a hunter onto the front of a room's list of hunters in constant time. The caller holds the room's roomHunterMutex,
+              or is the only thread using the house.
+    Params:   
+        Input/Output: Room* room - points to the room the hunter is in.
+        Input/Output: Hunter* hunter - points to the Hunter being linked, which is in no room's list.
+    Return: void
+*/
+void linkHunter(Room* room, Hunter* hunter){
+    hunter->prevInRoom = NULL;
+    hunter->nextInRoom = room->hunterHead;
+    if(room->hunterHead != NULL){
+        room->hunterHead->prevInRoom = hunter;
+    }
+    room->hunterHead = hunter;
+    //The room's bit in the hunter bitmap is set by the first hunter in
+    if(room->hunterCount++ == 0){
+        atomic_fetch_or_explicit(&(room->graph->hunterRooms[room->id / OCCUPANCY_BITS]), 1ULL << (room->id % OCCUPANCY_BITS), memory_order_relaxed);
     }
 }
 
 /* 
-    Function: addHunter(Hunter* hunter, Room* entering)
-    Purpose:  Adds a given hunter to the specified room.
+    Function: unlinkHunter(Room* room, Hunter* hunter)
+    Purpose:  Takes a hunter out of a room's list of hunters in constant time, using the hunter's own links. The caller holds the room's roomHunterMutex.
     Params:   
-        Input/Output: Hunter* hunter - points to the Hunter being added to the specified room.
-        Input/Output: Room* entering - points to the room the hunter is entering.
+        Input/Output: Room* room - points to the room the hunter is in.
+        Input/Output: Hunter* hunter - points to the Hunter being unlinked.
     Return: void
 */
-void addHunter(Hunter* hunter, Room* entering){
-    if(sem_wait(&(entering->roomHunterMutex)) == 0){
-        //Add hunter to entering room
-        for(int i = 0; i < NUM_HUNTERS; i++){
-            if(entering->curHunters[i] == NULL){
-                entering->curHunters[i] = hunter;
-                l_hunterMove(hunter->hunterName, entering->roomName);
-                break;
-            }
-        }
-        hunter->curRoom = entering;
-        sem_post(&(entering->roomHunterMutex));
-    }    
+void unlinkHunter(Room* room, Hunter* hunter){
+    if(hunter->prevInRoom != NULL){
+        hunter->prevInRoom->nextInRoom = hunter->nextInRoom;
+    }
+    else{
+        room->hunterHead = hunter->nextInRoom;
+    }
+    if(hunter->nextInRoom != NULL){
+        hunter->nextInRoom->prevInRoom = hunter->prevInRoom;
+    }
+    hunter->prevInRoom = NULL;
+    hunter->nextInRoom = NULL;
+    //and cleared by the last one out
+    if(--room->hunterCount == 0){
+        atomic_fetch_and_explicit(&(room->graph->hunterRooms[room->id / OCCUPANCY_BITS]), ~(1ULL << (room->id % OCCUPANCY_BITS)), memory_order_relaxed);
+    }
 }
 
 /* 
@@ -134,111 +198,92 @@ void addHunter(Hunter* hunter, Room* entering){
 */
 void collectEvidence(Hunter* hunter){
     //Removes evidence correlated with the hunter's equipment from the room, and then returns if no evidence found
-    if(removeEvidence(hunter) == C_FALSE){
+    int ghostType = removeEvidence(hunter);
+    if(ghostType == GH_UNKNOWN){
         return;
     }
-    l_hunterCollect(hunter->hunterName, hunter->reader, hunter->curRoom->roomName);
-    if(sem_wait(&(hunter->sharedEvidencePointer->evidenceMutex)) == 0){
-        //Checks if the evidence is already in the shared evidence list, and returns if so
-        if(hunter->sharedEvidencePointer->head != NULL){
-            EvidenceNode* curNode = hunter->sharedEvidencePointer->head;
-            while(curNode != NULL){
-                if(curNode->data == hunter->reader){
-                    sem_post(&(hunter->sharedEvidencePointer->evidenceMutex));
-                    return;
-                }
-                curNode = curNode->next;
-            }
-        }
-        sem_post(&(hunter->sharedEvidencePointer->evidenceMutex)); 
+    l_hunterCollect(hunter, hunter->reader, hunter->curRoom);
+    SharedEvidence* shared = hunter->sharedEvidencePointer;
+    int index = ghostType * EV_COUNT + hunter->reader;
+    unsigned int bit = 1u << index;
+    //Publishes the evidence type with a single fetch-or, only the hunter that actually set the bit records its position
+    unsigned int before = atomic_fetch_or_explicit(&(shared->found), bit, memory_order_acq_rel);
+    if((before & bit) == 0){
+        int slot = atomic_fetch_add_explicit(&(shared->size), 1, memory_order_relaxed);
+        shared->order[slot] = index;
     }
-    //add hunter->reader to the tail of the shared evidence list
-    addEvidence(hunter->sharedEvidencePointer, hunter->reader);
 }
 
 /* 
-    Function: removeEvidence(Hunter* hunter, int* found)
+    Function: removeEvidence(Hunter* hunter)
     Purpose:  Removes a piece of evidence from a room if the hunter is able to read the evidence.
     Params:   
         Input/Output: Hunter* hunter - points to the Hunter removing evidence from a room.
-    Return: int - returns a value of C_TRUE if a hunter was able to successfully collect evidence from the room, or C_FALSE otherwise
+    Return: int - returns the GhostClass that left the piece the hunter collected, or GH_UNKNOWN if there was nothing to collect
 */
 int removeEvidence(Hunter* hunter){
-    int found = C_FALSE;
-    if(sem_wait(&(hunter->curRoom->evidenceList.evidenceMutex)) == 0){
-        EvidenceNode* prev = NULL;
-        EvidenceNode* curNode = hunter->curRoom->evidenceList.head;
-        //Loops through the evidence list and removes all evidence matching the hunter's equipment    
-        while(curNode != NULL){
-            if(curNode->data == hunter->reader){
-                //Removing from head
-                if(curNode == hunter->curRoom->evidenceList.head){
-                    prev = hunter->curRoom->evidenceList.head;
-                    hunter->curRoom->evidenceList.head = prev->next;
-                    free(prev);
-                }
-                //Removing from tail
-                else if(curNode == hunter->curRoom->evidenceList.tail){
-                    hunter->curRoom->evidenceList.tail = prev;
-                    free(curNode);
-                    prev->next = NULL;
-                }
-                //Removing from the middle
-                else{
-                    prev->next = curNode->next;
-                    free(curNode);
-                }
-                found = C_TRUE;
-                break;
-            }
-            prev = curNode;
-            curNode = curNode->next;
+    int found = GH_UNKNOWN;
+    RoomEvidence* evidence = &(hunter->curRoom->evidence);
+    LOCK(&(evidence->evidenceMutex));
+    //Takes one piece of evidence matching the hunter's equipment, if there is any
+    for(int ghostType = 0; ghostType < GHOST_COUNT; ghostType++){
+        if(evidence->counts[ghostType][hunter->reader] > 0){
+            evidence->counts[ghostType][hunter->reader]--;
+            found = ghostType;
+            break;
         }
-        sem_post(&(hunter->curRoom->evidenceList.evidenceMutex));
     }
+    UNLOCK(&(evidence->evidenceMutex));
     return found;
 }
 
 /* 
     Function: reviewEvidence(Hunter* hunter)
     Purpose:  Allows a hunter to review all of the evidence in the hunter's shared evidence list.
+              The evidence is sufficient once every kind of ghost the hunters have found evidence of has been identified.
     Params:   
-        Input: Hunter* hunter - points to the Hunter reviewing the sharedEvidenceList.
-    Return: int - returns a value of C_TRUE if the hunter has enough evidence to know what ghost is present, or C_FALSE otherwise
+        Input: Hunter* hunter - points to the Hunter reviewing the shared evidence.
+    Return: int - returns a value of C_TRUE if the hunter has enough evidence to know what ghosts are present, or C_FALSE otherwise
 */
 int reviewEvidence(Hunter* hunter){
-    if(sem_wait(&(hunter->sharedEvidencePointer->evidenceMutex)) == 0){
-        //Checks if the hunters have found the amount of evidence they need and returns C_TRUE or C_FALSE accordingly
-        if(hunter->sharedEvidencePointer->size >= DESIRED_EVIDENCE_COUNT){
-            sem_post(&(hunter->sharedEvidencePointer->evidenceMutex));
-            l_hunterReview(hunter->hunterName, LOG_SUFFICIENT);
-            return C_TRUE;
+    //Checks if the hunters have found the amount of evidence they need and returns C_TRUE or C_FALSE accordingly
+    unsigned int found = atomic_load_explicit(&(hunter->sharedEvidencePointer->found), memory_order_acquire);
+    int sufficient = (found != 0) ? C_TRUE : C_FALSE;
+    for(int ghostType = 0; ghostType < GHOST_COUNT; ghostType++){
+        unsigned int classBits = (found >> (ghostType * EV_COUNT)) & ((1u << EV_COUNT) - 1);
+        if(classBits != 0 && ghostByMask(classBits) == GH_UNKNOWN){
+            sufficient = C_FALSE;
         }
-        sem_post(&(hunter->sharedEvidencePointer->evidenceMutex));
-        l_hunterReview(hunter->hunterName, LOG_INSUFFICIENT);
-        return C_FALSE;
     }
+    if(sufficient == C_TRUE){
+        l_hunterReview(hunter, LOG_SUFFICIENT);
+        return C_TRUE;
+    }
+    l_hunterReview(hunter, LOG_INSUFFICIENT);
+    return C_FALSE;
 }
 
 /*
     Function: isHunterleaving(Hunter* curHunter)
-    Purpose: checks if the hunter is leaving due to boredom or fear
+    Purpose: checks if the hunter is leaving due to boredom or fear. Fear grows with the number of ghosts in the room
     Params:
         Input/Output: Hunter* curHunter - points to the hunter being checked
     Return: int - returns C_TRUE if the hunter is leaving, or C_FALSE otherwise
 */
 int isHunterleaving(Hunter* curHunter){
-    if(isGhostInRoom(curHunter->curRoom) == C_TRUE){
-        curHunter->fear += FEAR_INCREMENT;
+    int ghosts = isGhostInRoom(curHunter->curRoom);
+    if(ghosts > 0){
+        //Every ghost in the room scares the hunter, so fear can jump past FEAR_MAX
+        curHunter->fear += FEAR_INCREMENT * ghosts;
         curHunter->boredom = 0;
-        if(curHunter->fear == FEAR_MAX){
-            l_hunterExit(curHunter->hunterName, LOG_FEAR);
+        if(curHunter->fear >= FEAR_MAX){
+            l_hunterExit(curHunter, LOG_FEAR);
             return C_TRUE;
         }
     } else {
         curHunter->boredom++;
         if(curHunter->boredom == BOREDOM_MAX){
-            l_hunterExit(curHunter->hunterName, LOG_BORED);
+            l_hunterExit(curHunter, LOG_BORED);
             return C_TRUE;
         }
     }
@@ -247,18 +292,12 @@ int isHunterleaving(Hunter* curHunter){
 
 /* 
     Function: isGhostInRoom(Room* curRoom)
-    Purpose:  Determine if there is a ghost inside the room with the hunter.
+    Purpose:  Determine how many ghosts are inside the room with the hunter.
     Params:   
         Input: Room* curRoom - points to the room we are checking contains the ghost.
-    Return: int - returns C_FALSE if there is no ghost in the room or C_TRUE if there is a ghost in the room.
+    Return: int - returns the number of ghosts in the room, 0 if there are none.
 */
 int isGhostInRoom(Room* curRoom){
-    int ghostInRoom = C_FALSE;
-    if(sem_wait(&(curRoom->roomGhostMutex)) == 0){
-        if(curRoom->ghost != NULL){
-            ghostInRoom = C_TRUE;
-        }
-        sem_post(&(curRoom->roomGhostMutex));
-    }
-    return ghostInRoom;
+    //The house's occupancy index counts the ghosts in every room, no lock is taken
+    return atomic_load_explicit(&(curRoom->graph->ghostCounts[curRoom->id]), memory_order_relaxed);
 }
\ No newline at end of file
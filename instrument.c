@@ -0,0 +1,299 @@
+#include "defs.h"
+
+//Everything here is only built with 'make INSTRUMENT=1', otherwise the LOCK/UNLOCK and INSTR_* macros in defs.h
+//go straight to pthread_mutex_* and this file is empty
+#ifdef INSTRUMENT
+#include <signal.h>
+
+//Forward declarations
+int instrBucket(long ns);
+long instrPercentile(atomic_long* hist, long count, double fraction);
+void* runReporter(void* arg);
+int compareRoomWait(const void* a, const void* b);
+void reportLocks(LockKind kind);
+
+//Statistics of every room lock, indexed by (room id * LOCK_KINDS + kind). The table is sized by the first game,
+//rooms beyond it share one extra slot, so pointers handed to earlier games never move
+static InstrStats* lockTable = NULL;
+static int tableRooms = 0;
+static char (*tableNames)[MAX_STR] = NULL;
+static pthread_mutex_t tableMutex = PTHREAD_MUTEX_INITIALIZER;
+static InstrStats actionStats[FN_COUNT];
+static pthread_mutex_t reportMutex = PTHREAD_MUTEX_INITIALIZER;
+static LockKind sortKind;
+
+static const char* actionNames[FN_COUNT] = {"isHunterleaving", "collectEvidence", "moveHunter", "reviewEvidence",
+                                            "isGhostLeaving", "leaveEvidence", "moveRoom"};
+static const char* lockNames[LOCK_KINDS] = {"roomHunterMutex", "roomGhostMutex", "evidenceMutex"};
+
+/*
+    Function: instrInit()
+    Purpose:  Arranges for the report to be printed at exit and whenever the process receives SIGUSR1.
+              SIGUSR1 is blocked here, before any other thread exists, so every thread inherits the mask and only the
+              reporter thread, waiting in sigwait, ever takes the signal. Call it first thing in main.
+    Return: void
+*/
+void instrInit(){
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    pthread_t reporter;
+    pthread_create(&reporter, NULL, runReporter, NULL);
+    pthread_detach(reporter);
+    atexit(instrReport);
+}
+
+/*
+    Function: runReporter(void* arg)
+    Purpose:  Runs the reporter thread, which prints the report every time SIGUSR1 arrives.
+    Params:
+        Input: void* arg - unused.
+    Return: void*
+*/
+void* runReporter(void* arg){
+    (void) arg;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    int signal;
+    while(sigwait(&set, &signal) == 0){
+        instrReport();
+    }
+    return NULL;
+}
+
+/*
+    Function: instrBeginGame(HouseType* house)
+    Purpose:  Points every lock of a freshly built house at the statistics of its room, so games of a batch add up per room.
+    Params:
+        Input/Output: HouseType* house - points to a compiled house whose room locks are attached.
+    Return: void
+*/
+void instrBeginGame(HouseType* house){
+    RoomGraph* graph = &(house->graph);
+    pthread_mutex_lock(&tableMutex);
+    if(lockTable == NULL){
+        tableRooms = graph->numRooms;
+        lockTable = (InstrStats*) calloc((tableRooms + 1) * LOCK_KINDS, sizeof(InstrStats));
+        tableNames = malloc(sizeof(*tableNames) * (tableRooms + 1));
+        for(int i = 0; i < tableRooms; i++){
+            strcpy(tableNames[i], graph->rooms[i]->roomName);
+        }
+        strcpy(tableNames[tableRooms], "(other rooms)");
+    }
+    pthread_mutex_unlock(&tableMutex);
+    for(int i = 0; i < graph->numRooms; i++){
+        Room* room = graph->rooms[i];
+        InstrStats* stats = &(lockTable[((i < tableRooms) ? i : tableRooms) * LOCK_KINDS]);
+        room->roomHunterMutex.stats = &(stats[LOCK_HUNTERS]);
+        room->roomGhostMutex.stats = &(stats[LOCK_GHOSTS]);
+        room->evidence.evidenceMutex.stats = &(stats[LOCK_EVIDENCE]);
+    }
+}
+
+/*
+    Function: instrLock(RoomLock* lock)
+    Purpose:  Locks a room lock, timing how long the caller had to wait for it.
+    Params:
+        Input/Output: RoomLock* lock - points to the lock.
+    Return: void
+*/
+void instrLock(RoomLock* lock){
+    if(lock->stats == NULL){
+        pthread_mutex_lock(&(lock->mutex));
+        return;
+    }
+    long wait = 0;
+    if(pthread_mutex_trylock(&(lock->mutex)) != 0){
+        long start = instrNow();
+        pthread_mutex_lock(&(lock->mutex));
+        wait = instrNow() - start;
+        atomic_fetch_add_explicit(&(lock->stats->contended), 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&(lock->stats->count), 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&(lock->stats->waitNs), wait, memory_order_relaxed);
+    atomic_fetch_add_explicit(&(lock->stats->waitHist[instrBucket(wait)]), 1, memory_order_relaxed);
+    lock->lockedAt = instrNow();
+}
+
+/*
+    Function: instrTryLock(RoomLock* lock)
+    Purpose:  Tries to lock a room lock without waiting. A successful attempt counts as an acquisition with no wait.
+    Params:
+        Input/Output: RoomLock* lock - points to the lock.
+    Return: int - returns 0 if the lock was taken, or an error number if it was busy
+*/
+int instrTryLock(RoomLock* lock){
+    int result = pthread_mutex_trylock(&(lock->mutex));
+    if(result == 0 && lock->stats != NULL){
+        atomic_fetch_add_explicit(&(lock->stats->count), 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(lock->stats->waitHist[0]), 1, memory_order_relaxed);
+        lock->lockedAt = instrNow();
+    }
+    return result;
+}
+
+/*
+    Function: instrUnlock(RoomLock* lock)
+    Purpose:  Unlocks a room lock, recording how long it was held.
+    Params:
+        Input/Output: RoomLock* lock - points to the lock.
+    Return: void
+*/
+void instrUnlock(RoomLock* lock){
+    if(lock->stats != NULL){
+        long hold = instrNow() - lock->lockedAt;
+        atomic_fetch_add_explicit(&(lock->stats->holdNs), hold, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(lock->stats->holdHist[instrBucket(hold)]), 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&(lock->mutex));
+}
+
+/*
+    Function: instrNow()
+    Purpose:  Reads the clock used for every instrumentation timing.
+    Return: long - returns the monotonic time in nanoseconds.
+*/
+long instrNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/*
+    Function: instrCall(InstrFunction fn, long start)
+    Purpose:  Records one call of an agent action.
+    Params:
+        Input: InstrFunction fn - stores which action was called.
+        Input: long start - stores the instrNow() reading taken just before the call.
+    Return: void
+*/
+void instrCall(InstrFunction fn, long start){
+    long latency = instrNow() - start;
+    atomic_fetch_add_explicit(&(actionStats[fn].count), 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&(actionStats[fn].waitNs), latency, memory_order_relaxed);
+    atomic_fetch_add_explicit(&(actionStats[fn].waitHist[instrBucket(latency)]), 1, memory_order_relaxed);
+}
+
+/*
+    Function: instrBucket(long ns)
+    Purpose:  Finds the histogram bucket of a time, the number of bits needed to write it.
+    Params:
+        Input: long ns - stores the time in nanoseconds.
+    Return: int - returns the bucket, b for times from 2^(b-1) up to 2^b - 1 ns.
+*/
+int instrBucket(long ns){
+    if(ns <= 0){
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzl((unsigned long) ns);
+    return (bucket < INSTR_BUCKETS) ? bucket : INSTR_BUCKETS - 1;
+}
+
+/*
+    Function: instrPercentile(atomic_long* hist, long count, double fraction)
+    Purpose:  Reads a percentile off a histogram, rounded up to the end of its bucket.
+    Params:
+        Input: atomic_long* hist - points to the histogram.
+        Input: long count - stores the number of samples in it.
+        Input: double fraction - stores the percentile as a fraction, 0.99 for p99.
+    Return: long - returns the upper bound of the bucket holding the percentile in nanoseconds.
+*/
+long instrPercentile(atomic_long* hist, long count, double fraction){
+    long seen = 0;
+    for(int b = 0; b < INSTR_BUCKETS; b++){
+        seen += atomic_load_explicit(&(hist[b]), memory_order_relaxed);
+        if(seen >= fraction * count){
+            return (b == 0) ? 0 : (1L << b) - 1;
+        }
+    }
+    return (1L << (INSTR_BUCKETS - 1)) - 1;
+}
+
+/*
+    Function: instrReport()
+    Purpose:  Prints the agent action latencies and, for each kind of room lock, the rooms that were waited on the longest.
+              Agents keep running while it prints, so the numbers of a live game are a snapshot.
+    Return: void
+*/
+void instrReport(){
+    pthread_mutex_lock(&reportMutex);
+    fprintf(stderr, "=======================================\n");
+    fprintf(stderr, "Instrumentation report\n");
+    fprintf(stderr, "=======================================\n");
+    fprintf(stderr, "    %-20s %12s %12s %12s %12s\n", "Action", "calls", "mean ns", "p50 ns <=", "p99 ns <=");
+    for(int fn = 0; fn < FN_COUNT; fn++){
+        long count = atomic_load(&(actionStats[fn].count));
+        if(count == 0){
+            continue;
+        }
+        fprintf(stderr, "    %-20s %12ld %12ld %12ld %12ld\n", actionNames[fn], count, atomic_load(&(actionStats[fn].waitNs)) / count,
+            instrPercentile(actionStats[fn].waitHist, count, 0.5), instrPercentile(actionStats[fn].waitHist, count, 0.99));
+    }
+    pthread_mutex_lock(&tableMutex);
+    if(lockTable != NULL){
+        for(int kind = 0; kind < LOCK_KINDS; kind++){
+            reportLocks(kind);
+        }
+    }
+    pthread_mutex_unlock(&tableMutex);
+    pthread_mutex_unlock(&reportMutex);
+}
+
+/*
+    Function: reportLocks(LockKind kind)
+    Purpose:  Prints the totals of one kind of room lock and its INSTR_TOP_ROOMS rooms with the most time spent waiting.
+    Params:
+        Input: LockKind kind - stores the kind of lock.
+    Return: void
+*/
+void reportLocks(LockKind kind){
+    int numRooms = tableRooms + 1;
+    int* order = (int*) malloc(sizeof(int) * numRooms);
+    long acquires = 0, contended = 0, waitNs = 0;
+    for(int i = 0; i < numRooms; i++){
+        InstrStats* stats = &(lockTable[i * LOCK_KINDS + kind]);
+        order[i] = i;
+        acquires += atomic_load(&(stats->count));
+        contended += atomic_load(&(stats->contended));
+        waitNs += atomic_load(&(stats->waitNs));
+    }
+    fprintf(stderr, "%s: %ld acquisitions, %ld contended (%.2f%%), %.3f ms waited in total\n", lockNames[kind], acquires, contended,
+        100.0 * contended / (acquires > 0 ? acquires : 1), waitNs / 1e6);
+    sortKind = kind;
+    qsort(order, numRooms, sizeof(int), compareRoomWait);
+    fprintf(stderr, "    %-24s %10s %10s %10s %10s %10s %10s\n", "Room", "acquires", "contended", "wait ns", "p99 wait", "hold ns", "p99 hold");
+    for(int i = 0; i < numRooms && i < INSTR_TOP_ROOMS; i++){
+        InstrStats* stats = &(lockTable[order[i] * LOCK_KINDS + kind]);
+        long count = atomic_load(&(stats->count));
+        if(count == 0){
+            break;
+        }
+        fprintf(stderr, "    %-24s %10ld %10ld %10ld %10ld %10ld %10ld\n", tableNames[order[i]], count, atomic_load(&(stats->contended)),
+            atomic_load(&(stats->waitNs)) / count, instrPercentile(stats->waitHist, count, 0.99),
+            atomic_load(&(stats->holdNs)) / count, instrPercentile(stats->holdHist, count, 0.99));
+    }
+    free(order);
+}
+
+/*
+    Function: compareRoomWait(const void* a, const void* b)
+    Purpose:  Orders room ids by the total time waited on their lock of kind sortKind, longest first, then by acquisitions.
+    Params:
+        Input: const void* a - points to the first room id.
+        Input: const void* b - points to the second room id.
+    Return: int - returns a negative number if a comes first, a positive number if b does, or 0 if they tie.
+*/
+int compareRoomWait(const void* a, const void* b){
+    InstrStats* first = &(lockTable[*(const int*) a * LOCK_KINDS + sortKind]);
+    InstrStats* second = &(lockTable[*(const int*) b * LOCK_KINDS + sortKind]);
+    long waitA = atomic_load(&(first->waitNs)), waitB = atomic_load(&(second->waitNs));
+    if(waitA != waitB){
+        return (waitA > waitB) ? -1 : 1;
+    }
+    long countA = atomic_load(&(first->count)), countB = atomic_load(&(second->count));
+    return (countA > countB) ? -1 : (countA < countB) ? 1 : 0;
+}
+
+#endif
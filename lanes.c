@@ -0,0 +1,507 @@
+#include "defs.h"
+
+//The turn kernels are compiled once per instruction set and the best one the CPU has is picked when the program starts.
+//The lane helpers are always inlined, so each copy of a kernel runs them with its own instruction set
+#define LANE_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#define LANE_INLINE static inline __attribute__((always_inline))
+
+//Forward declarations
+void playLanes(Worker* worker, LaneWorld* world, unsigned int* victimSeed);
+long lanePeriod();
+void* laneAlloc(size_t bytes);
+
+/*
+    Function: runLanes(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed)
+    Purpose:  Plays run ids from the farm LANES games at a time until every deque is empty, adding the results to the worker's stats.
+              Houses with more than LANES_MAX_ROOMS rooms are played one game at a time on the tick engine instead.
+    Params:
+        Input/Output: Worker* worker - points to the worker running the lanes.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters.
+        Input/Output: unsigned int* victimSeed - stores the state findTask uses to pick a victim.
+    Return: void
+*/
+void runLanes(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed){
+    Options* options = worker->options;
+    //A game is built once for its floor plan, every lane plays in its room graph
+    HouseType house;
+    initGame(&house, hunterNames, options->hunters, options->ghosts, -1);
+    if(house.graph.numRooms > LANES_MAX_ROOMS){
+        Options tick = *options;
+        tick.engine = ENGINE_TICK;
+        int run;
+        while(findTask(worker, victimSeed, &run) == C_TRUE){
+            GameResult result;
+            runGame(&tick, run, hunterNames, &result);
+            recordResult(&(worker->stats), &result);
+        }
+        freeProgram(&house);
+        return;
+    }
+    LaneWorld world;
+    initLaneWorld(&world, &(house.graph), options->hunters, options->ghosts);
+    playLanes(worker, &world, victimSeed);
+    freeLaneWorld(&world);
+    freeProgram(&house);
+}
+
+/*
+    Function: playLanes(Worker* worker, LaneWorld* world, unsigned int* victimSeed)
+    Purpose:  Runs the shared clock of the lanes. Every GHOST_WAIT the ghosts of every lane take their turn, every HUNTER_WAIT the
+              hunters do, and the hunters go first on ties as on the virtual engine, so each lane plays exactly the game the
+              virtual engine plays for its run id. A lane's game ends after the hunters' turn that decides it, and the lane gets
+              the next run id at the next multiple of both waits.
+    Params:
+        Input/Output: Worker* worker - points to the worker, its stats get the result of every game.
+        Input/Output: LaneWorld* world - points to the lanes, all of them idle.
+        Input/Output: unsigned int* victimSeed - stores the state findTask uses to pick a victim.
+    Return: void
+*/
+void playLanes(Worker* worker, LaneWorld* world, unsigned int* victimSeed){
+    long period = lanePeriod();
+    long hunterTime = HUNTER_WAIT;
+    long ghostTime = GHOST_WAIT;
+    long now = 0;
+    int playing = 0;
+    int more = C_TRUE;
+    int refill = C_TRUE;
+    while(C_TRUE){
+        //Idle lanes start their next game on a multiple of both waits, so its agents keep their cadence on the shared clock
+        if(refill == C_TRUE){
+            for(int lane = 0; lane < LANES && more == C_TRUE; lane++){
+                int run;
+                if(world->active[lane] != 0){
+                    continue;
+                }
+                if(findTask(worker, victimSeed, &run) == C_FALSE){
+                    more = C_FALSE;
+                    break;
+                }
+                startLaneGame(world, lane, run, now);
+                playing++;
+            }
+        }
+        if(playing == 0 && more == C_FALSE){
+            break;
+        }
+        int hunters = (hunterTime <= ghostTime) ? C_TRUE : C_FALSE;
+        now = (hunters == C_TRUE) ? hunterTime : ghostTime;
+        for(int lane = 0; lane < LANES; lane++){
+            if((hunters == C_TRUE) ? world->huntersLeft[lane] > 0 : world->ghostsLeft[lane] > 0){
+                world->last[lane] = now;
+            }
+        }
+        if(hunters == C_TRUE){
+            for(int i = 0; i < world->numHunters; i++){
+                laneHunterTurn(world, i);
+            }
+            hunterTime += HUNTER_WAIT;
+        }
+        else{
+            for(int i = 0; i < world->numGhosts; i++){
+                laneGhostTurn(world, i);
+            }
+            ghostTime += GHOST_WAIT;
+        }
+        for(int lane = 0; lane < LANES; lane++){
+            if(world->active[lane] != 0 && (world->huntersLeft[lane] == 0 || world->decided[lane] != 0)){
+                GameResult result;
+                finishLaneGame(world, lane, &result);
+                recordResult(&(worker->stats), &result);
+                playing--;
+            }
+        }
+        //Games start after the ghosts' turn, the hunters' turn at the same time comes first and would skip their first wait
+        refill = (hunters == C_FALSE && now % period == 0) ? C_TRUE : C_FALSE;
+    }
+}
+
+/*
+    Function: lanePeriod()
+    Purpose:  Finds the interval at which both the hunters and the ghosts take a turn.
+    Return: long - returns the least common multiple of HUNTER_WAIT and GHOST_WAIT.
+*/
+long lanePeriod(){
+    long a = HUNTER_WAIT, b = GHOST_WAIT;
+    while(b != 0){
+        long rest = a % b;
+        a = b;
+        b = rest;
+    }
+    return (long) HUNTER_WAIT / a * GHOST_WAIT;
+}
+
+/*
+    Function: initLaneWorld(LaneWorld* world, RoomGraph* graph, int numHunters, int numGhosts)
+    Purpose:  Allocates the lanes for games with the given numbers of agents, all of them idle. Idle lanes still go through the
+              kernels masked off, so everything starts zeroed to keep their rooms and classes valid indexes.
+    Params:
+        Output: LaneWorld* world - points to the lanes being set up.
+        Input: RoomGraph* graph - points to the room graph every game is played in, it has to outlive the lanes.
+        Input: int numHunters - stores the number of hunters in every game.
+        Input: int numGhosts - stores the number of ghosts in every game.
+    Return: void
+*/
+void initLaneWorld(LaneWorld* world, RoomGraph* graph, int numHunters, int numGhosts){
+    memset(world, 0, sizeof(LaneWorld));
+    world->numHunters = numHunters;
+    world->numGhosts = numGhosts;
+    world->numRooms = graph->numRooms;
+    world->offsets = graph->offsets;
+    world->neighbours = graph->neighbours;
+    size_t row = sizeof(int) * LANES;
+    world->hunterRoom = (int*) laneAlloc(row * numHunters);
+    world->fear = (int*) laneAlloc(row * numHunters);
+    world->boredom = (int*) laneAlloc(row * numHunters);
+    world->hunterAlive = (int*) laneAlloc(row * numHunters);
+    world->hunterRng = (LaneRng*) laneAlloc(sizeof(LaneRng) * numHunters);
+    world->ghostRoom = (int*) laneAlloc(row * numGhosts);
+    world->ghostBored = (int*) laneAlloc(row * numGhosts);
+    world->ghostAlive = (int*) laneAlloc(row * numGhosts);
+    world->ghostClass = (int*) laneAlloc(row * numGhosts);
+    world->ghostRng = (LaneRng*) laneAlloc(sizeof(LaneRng) * numGhosts);
+    world->roomHunters = (int*) laneAlloc(row * graph->numRooms);
+    world->roomGhosts = (int*) laneAlloc(row * graph->numRooms);
+    world->evidence = (int*) laneAlloc(row * graph->numRooms * GHOST_COUNT * EV_COUNT);
+}
+
+/*
+    Function: laneAlloc(size_t bytes)
+    Purpose:  Allocates a zeroed array aligned to a whole row of lanes.
+    Params:
+        Input: size_t bytes - stores the size of the array, a multiple of a row.
+    Return: void* - returns the array.
+*/
+void* laneAlloc(size_t bytes){
+    void* array = aligned_alloc(sizeof(int) * LANES, bytes);
+    memset(array, 0, bytes);
+    return array;
+}
+
+/*
+    Function: freeLaneWorld(LaneWorld* world)
+    Purpose:  Frees the arrays of the lanes.
+    Params:
+        Input/Output: LaneWorld* world - points to the lanes.
+    Return: void
+*/
+void freeLaneWorld(LaneWorld* world){
+    free(world->hunterRoom);
+    free(world->fear);
+    free(world->boredom);
+    free(world->hunterAlive);
+    free(world->hunterRng);
+    free(world->ghostRoom);
+    free(world->ghostBored);
+    free(world->ghostAlive);
+    free(world->ghostClass);
+    free(world->ghostRng);
+    free(world->roomHunters);
+    free(world->roomGhosts);
+    free(world->evidence);
+}
+
+/*
+    Function: startLaneGame(LaneWorld* world, int lane, int runId, long now)
+    Purpose:  Sets a lane up for a game the way initGame does, drawing the ghosts' classes and rooms from the run's house stream
+              and seeding every agent's own stream.
+    Params:
+        Input/Output: LaneWorld* world - points to the lanes.
+        Input: int lane - stores the idle lane starting the game.
+        Input: int runId - stores the id of the run.
+        Input: long now - stores the time on the shared clock, a multiple of lanePeriod.
+    Return: void
+*/
+void startLaneGame(LaneWorld* world, int lane, int runId, long now){
+    for(int room = 0; room < world->numRooms; room++){
+        world->roomHunters[room * LANES + lane] = 0;
+        world->roomGhosts[room * LANES + lane] = 0;
+        for(int kind = 0; kind < GHOST_COUNT * EV_COUNT; kind++){
+            world->evidence[(room * GHOST_COUNT * EV_COUNT + kind) * LANES + lane] = 0;
+        }
+    }
+    Rng rng;
+    for(int i = 0; i < world->numHunters; i++){
+        int at = i * LANES + lane;
+        world->hunterRoom[at] = 0;
+        world->fear[at] = 0;
+        world->boredom[at] = 0;
+        world->hunterAlive[at] = -1;
+        rngInit(&rng, runId, RNG_STREAM_HUNTER + i);
+        for(int word = 0; word < 4; word++){
+            world->hunterRng[i].s[word][lane] = rng.s[word];
+        }
+    }
+    world->roomHunters[lane] = world->numHunters;
+    Rng houseRng;
+    rngInit(&houseRng, runId, RNG_STREAM_HOUSE);
+    rngUse(&houseRng);
+    for(int i = 0; i < world->numGhosts; i++){
+        int at = i * LANES + lane;
+        rngInit(&rng, runId, RNG_STREAM_GHOST + i);
+        for(int word = 0; word < 4; word++){
+            world->ghostRng[i].s[word][lane] = rng.s[word];
+        }
+        world->ghostClass[at] = randomGhost();
+        //Any room but the Van, which is room 0
+        world->ghostRoom[at] = randInt(0, world->numRooms - 1) + 1;
+        world->roomGhosts[world->ghostRoom[at] * LANES + lane]++;
+        world->ghostBored[at] = 0;
+        world->ghostAlive[at] = -1;
+    }
+    rngUse(NULL);
+    world->active[lane] = -1;
+    world->runId[lane] = runId;
+    world->start[lane] = now;
+    world->last[lane] = now;
+    world->huntersLeft[lane] = world->numHunters;
+    world->ghostsLeft[lane] = world->numGhosts;
+    world->decided[lane] = 0;
+    world->moves[lane] = 0;
+    world->found[lane] = 0;
+    world->orderSize[lane] = 0;
+}
+
+/*
+    Function: finishLaneGame(LaneWorld* world, int lane, GameResult* result)
+    Purpose:  Tallies the game a lane just finished, as evaluateGame does, and leaves the lane idle.
+    Params:
+        Input/Output: LaneWorld* world - points to the lanes.
+        Input: int lane - stores the lane whose game was decided.
+        Output: GameResult* result - points to the outcome of the game.
+    Return: void
+*/
+void finishLaneGame(LaneWorld* world, int lane, GameResult* result){
+    result->fearCount = 0;
+    result->boredCount = 0;
+    result->numHunters = world->numHunters;
+    for(int i = 0; i < world->numHunters; i++){
+        if(world->fear[i * LANES + lane] >= FEAR_MAX){
+            result->fearCount++;
+        }
+        else if(world->boredom[i * LANES + lane] >= BOREDOM_MAX){
+            result->boredCount++;
+        }
+    }
+    SharedEvidence shared;
+    atomic_init(&(shared.found), world->found[lane]);
+    atomic_init(&(shared.size), world->orderSize[lane]);
+    for(int i = 0; i < world->orderSize[lane]; i++){
+        shared.order[i] = world->order[i * LANES + lane];
+    }
+    result->guess = identifyGhosts(&shared);
+    result->actual = 0;
+    for(int i = 0; i < world->numGhosts; i++){
+        result->actual |= 1u << world->ghostClass[i * LANES + lane];
+    }
+    result->moveStats.moves = world->moves[lane];
+    result->moveStats.contended = 0;
+    result->length = world->last[lane] - world->start[lane];
+    //Agents still in the house of a decided game stop taking turns
+    for(int i = 0; i < world->numHunters; i++){
+        world->hunterAlive[i * LANES + lane] = 0;
+    }
+    for(int i = 0; i < world->numGhosts; i++){
+        world->ghostAlive[i * LANES + lane] = 0;
+    }
+    world->huntersLeft[lane] = 0;
+    world->ghostsLeft[lane] = 0;
+    world->active[lane] = 0;
+}
+
+/*
+    Function: laneNext(LaneRng* rng, const int* draw, uint64_t* out)
+    Purpose:  Steps the xoshiro256** stream of one agent in every lane, as rngNext does. Lanes that are not drawing keep their state.
+    Params:
+        Input/Output: LaneRng* rng - points to the agent's streams.
+        Input: const int* draw - stores -1 for the lanes drawing a value, 0 for the others.
+        Output: uint64_t* out - stores the value drawn in each lane.
+    Return: void
+*/
+LANE_INLINE void laneNext(LaneRng* rng, const int* draw, uint64_t* out){
+    for(int lane = 0; lane < LANES; lane++){
+        uint64_t s0 = rng->s[0][lane], s1 = rng->s[1][lane], s2 = rng->s[2][lane], s3 = rng->s[3][lane];
+        uint64_t keep = (uint64_t) (int64_t) draw[lane];
+        uint64_t scrambled = s1 * 5;
+        scrambled = ((scrambled << 7) | (scrambled >> 57)) * 9;
+        out[lane] = scrambled;
+        uint64_t t = s1 << 17;
+        uint64_t n2 = s2 ^ s0;
+        uint64_t n3 = s3 ^ s1;
+        uint64_t n1 = s1 ^ n2;
+        uint64_t n0 = s0 ^ n3;
+        n2 ^= t;
+        n3 = (n3 << 45) | (n3 >> 19);
+        rng->s[0][lane] = (n0 & keep) | (s0 & ~keep);
+        rng->s[1][lane] = (n1 & keep) | (s1 & ~keep);
+        rng->s[2][lane] = (n2 & keep) | (s2 & ~keep);
+        rng->s[3][lane] = (n3 & keep) | (s3 & ~keep);
+    }
+}
+
+/*
+    Function: laneBelow(LaneRng* rng, const int* n, const int* draw, int* out)
+    Purpose:  Draws a uniform integer below n in every drawing lane, exactly as rngBelow does. The rare draws rngBelow rejects are
+              redrawn one lane at a time.
+    Params:
+        Input/Output: LaneRng* rng - points to the agent's streams.
+        Input: const int* n - stores the size of the range in each lane, greater than 0.
+        Input: const int* draw - stores -1 for the lanes drawing a value, 0 for the others.
+        Output: int* out - stores the value drawn in each lane, below n even in the lanes that are not drawing.
+    Return: void
+*/
+LANE_INLINE void laneBelow(LaneRng* rng, const int* n, const int* draw, int* out){
+    uint64_t raw[LANES];
+    int retry = 0;
+    laneNext(rng, draw, raw);
+    for(int lane = 0; lane < LANES; lane++){
+        uint64_t m = (raw[lane] >> 32) * (uint32_t) n[lane];
+        out[lane] = (int) (m >> 32);
+        retry |= draw[lane] & -((uint32_t) m < (uint32_t) n[lane]);
+    }
+    if(retry == 0){
+        return;
+    }
+    for(int lane = 0; lane < LANES; lane++){
+        uint64_t m = (raw[lane] >> 32) * (uint32_t) n[lane];
+        if(draw[lane] == 0 || (uint32_t) m >= (uint32_t) n[lane]){
+            continue;
+        }
+        Rng scalar;
+        for(int word = 0; word < 4; word++){
+            scalar.s[word] = rng->s[word][lane];
+        }
+        uint32_t threshold = -(uint32_t) n[lane] % (uint32_t) n[lane];
+        while((uint32_t) m < threshold){
+            m = (rngNext(&scalar) >> 32) * (uint32_t) n[lane];
+        }
+        out[lane] = (int) (m >> 32);
+        for(int word = 0; word < 4; word++){
+            rng->s[word][lane] = scalar.s[word];
+        }
+    }
+}
+
+/*
+    Function: laneHunterTurn(LaneWorld* world, int hunter)
+    Purpose:  Performs one turn of a hunter in every lane, the same steps as hunterStep without a branch on any lane's state:
+              fear and boredom, then collecting, moving or reviewing as the hunter's stream decides. Lanes where the hunter
+              already left are masked off.
+    Params:
+        Input/Output: LaneWorld* world - points to the lanes.
+        Input: int hunter - stores the index of the hunter.
+    Return: void
+*/
+LANE_CLONES void laneHunterTurn(LaneWorld* world, int hunter){
+    int* room = &(world->hunterRoom[hunter * LANES]);
+    int* fear = &(world->fear[hunter * LANES]);
+    int* boredom = &(world->boredom[hunter * LANES]);
+    int* alive = &(world->hunterAlive[hunter * LANES]);
+    int reader = hunter % EV_COUNT;
+    int leaving[LANES], staying[LANES], choice[LANES], size[LANES], moving[LANES], pick[LANES];
+    //isHunterleaving
+    for(int lane = 0; lane < LANES; lane++){
+        int ghosts = world->roomGhosts[room[lane] * LANES + lane] & alive[lane];
+        int haunted = -(ghosts > 0);
+        fear[lane] += ghosts * FEAR_INCREMENT;
+        boredom[lane] = (alive[lane] & ~haunted & (boredom[lane] + 1)) | (~alive[lane] & boredom[lane]);
+        leaving[lane] = alive[lane] & -((fear[lane] >= FEAR_MAX) | (boredom[lane] == BOREDOM_MAX));
+        staying[lane] = alive[lane] & ~leaving[lane];
+        size[lane] = 3;
+    }
+    laneBelow(&(world->hunterRng[hunter]), size, staying, choice);
+    //collectEvidence takes the first class with evidence of the hunter's type, then publishes it
+    for(int lane = 0; lane < LANES; lane++){
+        int collecting = staying[lane] & -(choice[lane] == 0);
+        int found = -1;
+        for(int ghostClass = 0; ghostClass < GHOST_COUNT; ghostClass++){
+            int* count = &(world->evidence[((room[lane] * GHOST_COUNT + ghostClass) * EV_COUNT + reader) * LANES + lane]);
+            int take = collecting & -(*count > 0) & -(found < 0);
+            *count -= take & 1;
+            found = (take & ghostClass) | (~take & found);
+        }
+        int index = found * EV_COUNT + reader;
+        unsigned int bit = (found >= 0) ? 1u << index : 0;
+        int fresh = -((world->found[lane] & bit) == 0 && bit != 0);
+        int* slot = &(world->order[world->orderSize[lane] * LANES + lane]);
+        *slot = (fresh & index) | (~fresh & *slot);
+        world->orderSize[lane] += fresh & 1;
+        world->found[lane] |= bit;
+        size[lane] = world->offsets[room[lane] + 1] - world->offsets[room[lane]];
+        moving[lane] = staying[lane] & -(choice[lane] == 1);
+    }
+    //moveHunter
+    laneBelow(&(world->hunterRng[hunter]), size, moving, pick);
+    for(int lane = 0; lane < LANES; lane++){
+        int entering = world->neighbours[world->offsets[room[lane]] + pick[lane]];
+        //reviewEvidence, sufficient once the evidence of every class with evidence identifies a class
+        unsigned int found = world->found[lane];
+        int sufficient = -(found != 0);
+        for(int ghostClass = 0; ghostClass < GHOST_COUNT; ghostClass++){
+            unsigned int classBits = (found >> (ghostClass * EV_COUNT)) & ((1u << EV_COUNT) - 1);
+            sufficient &= -(classBits == 0 || ghostByEvidence[classBits] != 0);
+        }
+        //Hunters leaving for any reason are taken out of their room, as removeHunter does
+        int won = staying[lane] & -(choice[lane] == 2) & sufficient;
+        int done = leaving[lane] | won;
+        world->decided[lane] |= won;
+        alive[lane] &= ~done;
+        world->huntersLeft[lane] -= done & 1;
+        world->roomHunters[room[lane] * LANES + lane] -= (moving[lane] | done) & 1;
+        world->roomHunters[entering * LANES + lane] += moving[lane] & 1;
+        room[lane] = (moving[lane] & entering) | (~moving[lane] & room[lane]);
+        world->moves[lane] += moving[lane] & 1;
+    }
+}
+
+/*
+    Function: laneGhostTurn(LaneWorld* world, int ghost)
+    Purpose:  Performs one turn of a ghost in every lane, the same steps as ghostStep without a branch on any lane's state:
+              boredom and the choice of action, then leaving evidence, waiting or moving. Lanes where the ghost already left
+              are masked off.
+    Params:
+        Input/Output: LaneWorld* world - points to the lanes.
+        Input: int ghost - stores the index of the ghost.
+    Return: void
+*/
+LANE_CLONES void laneGhostTurn(LaneWorld* world, int ghost){
+    int* room = &(world->ghostRoom[ghost * LANES]);
+    int* bored = &(world->ghostBored[ghost * LANES]);
+    int* alive = &(world->ghostAlive[ghost * LANES]);
+    int* ghostClass = &(world->ghostClass[ghost * LANES]);
+    LaneRng* rng = &(world->ghostRng[ghost]);
+    int size[LANES], choice[LANES], pending[LANES], type[LANES];
+    //isGhostLeaving, a hunter in the room keeps the ghost there
+    for(int lane = 0; lane < LANES; lane++){
+        int hunted = -(world->roomHunters[room[lane] * LANES + lane] > 0);
+        bored[lane] = (alive[lane] & ~hunted & (bored[lane] + 1)) | (~alive[lane] & bored[lane]);
+        size[lane] = 3 + hunted;
+    }
+    laneBelow(rng, size, alive, choice);
+    for(int lane = 0; lane < LANES; lane++){
+        int leaving = alive[lane] & -(bored[lane] == BOREDOM_MAX);
+        alive[lane] &= ~leaving;
+        world->ghostsLeft[lane] -= leaving & 1;
+        pending[lane] = alive[lane] & -(choice[lane] == 0);
+        size[lane] = DESIRED_EVIDENCE_COUNT;
+    }
+    //leaveEvidence, one draw from the types the ghost's class leaves
+    laneBelow(rng, size, pending, type);
+    for(int lane = 0; lane < LANES; lane++){
+        int dropped = ghostEvidence[ghostClass[lane]][type[lane]];
+        world->evidence[((room[lane] * GHOST_COUNT + ghostClass[lane]) * EV_COUNT + dropped) * LANES + lane] += pending[lane] & 1;
+    }
+    //moveRoom
+    for(int lane = 0; lane < LANES; lane++){
+        size[lane] = world->offsets[room[lane] + 1] - world->offsets[room[lane]];
+        pending[lane] = alive[lane] & -(choice[lane] == 2);
+    }
+    laneBelow(rng, size, pending, type);
+    for(int lane = 0; lane < LANES; lane++){
+        int moving = pending[lane];
+        int entering = world->neighbours[world->offsets[room[lane]] + type[lane]];
+        world->roomGhosts[room[lane] * LANES + lane] -= moving & 1;
+        world->roomGhosts[entering * LANES + lane] += moving & 1;
+        room[lane] = (moving & entering) | (~moving & room[lane]);
+        world->moves[lane] += moving & 1;
+    }
+}
@@ -1,134 +1,424 @@
 #include "defs.h"
 
-/* 
+//Forward declarations
+void logRecord(HouseType* house, LogRecord* rec);
+int wantRecord(HouseType* house);
+void copyName(char* dest, const char* src);
+LogRing* getThreadRing();
+void closeThreadRing(void* ring);
+void* runFlusher(void* arg);
+int drainRings(char* batch, int* used);
+
+static int loggingEnabled = C_TRUE;
+
+//Background flusher state, the ring list is only changed while holding ringMutex
+static LogMode logMode = LOG_SYNC;
+static atomic_int flusherRunning = 0;
+static pthread_t flusherThread;
+static pthread_mutex_t ringMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ringKey;
+static LogRing* rings = NULL;
+static unsigned long droppedTotal = 0;
+static __thread LogRing* threadRing = NULL;
+
+/*
+    Turns logging on or off at runtime, for example to keep headless batch runs quiet.
+    in: enabled - C_TRUE to log, C_FALSE to stay silent
+*/
+void l_setEnabled(int enabled) {
+    loggingEnabled = enabled;
+}
+
+/*
+    Switches logging to the asynchronous backend. Each thread then fills its own lock-free ring with fixed-size
+    records, and a background thread formats them and writes them out in large batches.
+    in: mode - LOG_ASYNC_BLOCK to wait for room when a ring is full, LOG_ASYNC_DROP to drop the record instead
+*/
+void l_startAsync(LogMode mode) {
+    if (mode == LOG_SYNC || atomic_load(&flusherRunning)) return;
+    logMode = mode;
+    pthread_key_create(&ringKey, closeThreadRing);
+    atomic_store(&flusherRunning, C_TRUE);
+    pthread_create(&flusherThread, NULL, runFlusher, NULL);
+}
+
+/*
+    Waits until every record logged so far has been written out. Call it before printing anything else to stdout.
+*/
+void l_flush() {
+    if (!atomic_load(&flusherRunning)) {
+        fflush(stdout);
+        return;
+    }
+    while (C_TRUE) {
+        //The flusher writes its batch before it lets go of the mutex, so empty rings mean everything is out
+        int empty = C_TRUE;
+        pthread_mutex_lock(&ringMutex);
+        for (LogRing* ring = rings; ring != NULL; ring = ring->next) {
+            if (atomic_load_explicit(&ring->tail, memory_order_acquire) != atomic_load_explicit(&ring->head, memory_order_acquire)) {
+                empty = C_FALSE;
+            }
+        }
+        if (empty) {
+            fflush(stdout);
+        }
+        pthread_mutex_unlock(&ringMutex);
+        if (empty) return;
+        usleep(LOG_IDLE_WAIT / 10);
+    }
+}
+
+/*
+    Writes out everything still queued, stops the background flusher and goes back to printing directly.
+*/
+void l_stopAsync() {
+    if (!atomic_load(&flusherRunning)) return;
+    l_flush();
+    atomic_store(&flusherRunning, C_FALSE);
+    pthread_join(flusherThread, NULL);
+    pthread_mutex_lock(&ringMutex);
+    while (rings != NULL) {
+        LogRing* next = rings->next;
+        droppedTotal += atomic_load(&rings->dropped);
+        free(rings);
+        rings = next;
+    }
+    pthread_mutex_unlock(&ringMutex);
+    //Rings of threads that are still alive were just freed, they get a new one if they log again
+    threadRing = NULL;
+    pthread_setspecific(ringKey, NULL);
+    logMode = LOG_SYNC;
+    if (droppedTotal > 0) {
+        fprintf(stderr, "[LOGGER] dropped %lu records because a ring was full\n", droppedTotal);
+    }
+}
+
+/*
     Logs the hunter being created.
-    in: hunter - the hunter name to log
-    in: equipment - the hunter's equipment
+    in: hunter - the hunter to log, with its name and equipment
 */
-void l_hunterInit(char* hunter, enum EvidenceType equipment) {
-    if (!LOGGING) return;
-    char ev_str[MAX_STR];
-    evidenceToString(equipment, ev_str);
-    printf("[HUNTER INIT] [%s] is a [%s] hunter\n", hunter, ev_str);    
+void l_hunterInit(Hunter* hunter) {
+    if (!wantRecord(hunter->house)) return;
+    LogRecord rec = {EVT_HUNTER_INIT, hunter->reader, hunter->id, -1, "", ""};
+    copyName(rec.agent, hunter->hunterName);
+    logRecord(hunter->house, &rec);
 }
 
 /*
     Logs the hunter moving into a new room.
-    in: hunter - the hunter name to log
-    in: room - the room name to log
+    in: hunter - the hunter to log
+    in: room - the room to log
 */
-void l_hunterMove(char* hunter, char* room) {
-    if (!LOGGING) return;
-    printf("[HUNTER MOVE] [%s] has moved into [%s]\n", hunter, room);
+void l_hunterMove(Hunter* hunter, Room* room) {
+    if (!wantRecord(hunter->house)) return;
+    LogRecord rec = {EVT_HUNTER_MOVE, 0, hunter->id, room->id, "", ""};
+    copyName(rec.agent, hunter->hunterName);
+    copyName(rec.room, room->roomName);
+    logRecord(hunter->house, &rec);
 }
 
 /*
     Logs the hunter exiting the house.
-    in: hunter - the hunter name to log
+    in: hunter - the hunter to log
     in: reason - the reason for exiting, either LOG_FEAR, LOG_BORED, or LOG_EVIDENCE
 */
-void l_hunterExit(char* hunter, enum LoggerDetails reason) {
-    if (!LOGGING) return;
-    printf("[HUNTER EXIT] [%s] exited because ", hunter);
-    switch (reason) {
-        case LOG_FEAR:
-            printf("[FEAR]\n");
-            break;
-        case LOG_BORED:
-            printf("[BORED]\n");
-            break;
-        case LOG_EVIDENCE:
-            printf("[EVIDENCE]\n");
-            break;
-        default:
-            printf("[UNKNOWN]\n");
-    }
+void l_hunterExit(Hunter* hunter, enum LoggerDetails reason) {
+    if (!wantRecord(hunter->house)) return;
+    LogRecord rec = {EVT_HUNTER_EXIT, reason, hunter->id, -1, "", ""};
+    copyName(rec.agent, hunter->hunterName);
+    logRecord(hunter->house, &rec);
 }
 
 /*
     Logs the hunter reviewing evidence.
-    in: hunter - the hunter name to log
+    in: hunter - the hunter to log
     in: result - the result of the review, either LOG_SUFFICIENT or LOG_INSUFFICIENT
 */
-void l_hunterReview(char* hunter, enum LoggerDetails result) {
-    if (!LOGGING) return;
-    printf("[HUNTER REVIEW] [%s] reviewed evidence and found ", hunter);
-    switch (result) {
-        case LOG_SUFFICIENT:
-            printf("[SUFFICIENT]\n");
-            break;
-        case LOG_INSUFFICIENT:
-            printf("[INSUFFICIENT]\n");
-            break;
-        default:
-            printf("[UNKNOWN]\n");
-    }
+void l_hunterReview(Hunter* hunter, enum LoggerDetails result) {
+    if (!wantRecord(hunter->house)) return;
+    LogRecord rec = {EVT_HUNTER_REVIEW, result, hunter->id, -1, "", ""};
+    copyName(rec.agent, hunter->hunterName);
+    logRecord(hunter->house, &rec);
 }
 
 /*
     Logs the hunter collecting evidence.
-    in: hunter - the hunter name to log
+    in: hunter - the hunter to log
     in: evidence - the evidence type to log
-    in: room - the room name to log
+    in: room - the room to log
 */
-void l_hunterCollect(char* hunter, enum EvidenceType evidence, char* room) {
-    if (!LOGGING) return;
-    char ev_str[MAX_STR];
-    evidenceToString(evidence, ev_str);
-    printf("[HUNTER EVIDENCE] [%s] found [%s] in [%s] and [COLLECTED]\n", hunter, ev_str, room);
+void l_hunterCollect(Hunter* hunter, enum EvidenceType evidence, Room* room) {
+    if (!wantRecord(hunter->house)) return;
+    LogRecord rec = {EVT_HUNTER_COLLECT, evidence, hunter->id, room->id, "", ""};
+    copyName(rec.agent, hunter->hunterName);
+    copyName(rec.room, room->roomName);
+    logRecord(hunter->house, &rec);
 }
 
 /*
     Logs the ghost moving into a new room.
-    in: room - the room name to log
+    in: ghost - the ghost to log
+    in: room - the room to log
 */
-void l_ghostMove(char* room) {
-    if (!LOGGING) return;
-    printf("[GHOST MOVE] Ghost has moved into [%s]\n", room);
+void l_ghostMove(Ghost* ghost, Room* room) {
+    if (!wantRecord(ghost->house)) return;
+    LogRecord rec = {EVT_GHOST_MOVE, 0, ghost->id, room->id, "", ""};
+    ghostName(ghost->id, ghost->house->numGhosts, rec.agent);
+    copyName(rec.room, room->roomName);
+    logRecord(ghost->house, &rec);
 }
 
 /*
     Logs the ghost exiting the house.
+    in: ghost - the ghost to log
     in: reason - the reason for exiting, either LOG_FEAR, LOG_BORED, or LOG_EVIDENCE
 */
-void l_ghostExit(enum LoggerDetails reason) {
-    if (!LOGGING) return;
-    printf("[GHOST EXIT] Exited because ");
-    switch (reason) {
-        case LOG_FEAR:
-            printf("[FEAR]\n");
+void l_ghostExit(Ghost* ghost, enum LoggerDetails reason) {
+    if (!wantRecord(ghost->house)) return;
+    LogRecord rec = {EVT_GHOST_EXIT, reason, ghost->id, -1, "", ""};
+    ghostName(ghost->id, ghost->house->numGhosts, rec.agent);
+    logRecord(ghost->house, &rec);
+}
+
+/*
+    Logs the ghost leaving evidence in a room.
+    in: ghost - the ghost to log
+    in: evidence - the evidence type to log
+    in: room - the room to log
+*/
+void l_ghostEvidence(Ghost* ghost, enum EvidenceType evidence, Room* room) {
+    if (!wantRecord(ghost->house)) return;
+    LogRecord rec = {EVT_GHOST_EVIDENCE, evidence, ghost->id, room->id, "", ""};
+    ghostName(ghost->id, ghost->house->numGhosts, rec.agent);
+    copyName(rec.room, room->roomName);
+    logRecord(ghost->house, &rec);
+}
+
+/*
+    Logs the ghost being created.
+    in: ghost - the ghost to log, with its type and starting room
+*/
+void l_ghostInit(Ghost* ghost) {
+    if (!wantRecord(ghost->house)) return;
+    LogRecord rec = {EVT_GHOST_INIT, ghost->ghostType, ghost->id, ghost->curRoom->id, "", ""};
+    ghostName(ghost->id, ghost->house->numGhosts, rec.agent);
+    copyName(rec.room, ghost->curRoom->roomName);
+    logRecord(ghost->house, &rec);
+}
+
+/*
+    Checks whether anything is listening for records of the given game: the text log or the game's binary trace.
+    in: house - the house of the game
+    return: C_TRUE if a record should be built, C_FALSE otherwise
+*/
+int wantRecord(HouseType* house) {
+    return (LOGGING && loggingEnabled) || house->trace != NULL;
+}
+
+/*
+    Hands a record to the game's binary trace, if it has one, and to the active text backend:
+    printed right away, or queued on the calling thread's ring.
+    in: house - the house of the game the record belongs to
+    in: rec - the record to log
+*/
+void logRecord(HouseType* house, LogRecord* rec) {
+    if (house->trace != NULL) {
+        traceRecord(house, rec);
+    }
+    if (!LOGGING || !loggingEnabled) return;
+    if (!atomic_load_explicit(&flusherRunning, memory_order_relaxed)) {
+        char line[3 * MAX_STR];
+        int len = formatRecord(rec, line, sizeof(line));
+        fwrite(line, 1, len, stdout);
+        return;
+    }
+    LogRing* ring = getThreadRing();
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOG_RING_SIZE) {
+        if (logMode == LOG_ASYNC_DROP) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+        //Backpressure: wait for the flusher to make room
+        sched_yield();
+    }
+    ring->records[head % LOG_RING_SIZE] = *rec;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/*
+    Returns the calling thread's ring, creating and registering it on the thread's first record.
+*/
+LogRing* getThreadRing() {
+    if (threadRing == NULL) {
+        LogRing* ring = (LogRing*) malloc(sizeof(LogRing));
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->dropped, 0);
+        atomic_init(&ring->closed, C_FALSE);
+        pthread_mutex_lock(&ringMutex);
+        ring->next = rings;
+        rings = ring;
+        pthread_mutex_unlock(&ringMutex);
+        pthread_setspecific(ringKey, ring);
+        threadRing = ring;
+    }
+    return threadRing;
+}
+
+/*
+    Marks a ring as closed when its thread exits. The flusher frees it once it has been drained.
+    in: ring - the exiting thread's ring
+*/
+void closeThreadRing(void* ring) {
+    atomic_store_explicit(&((LogRing*) ring)->closed, C_TRUE, memory_order_release);
+}
+
+/*
+    Runs the background flusher thread. Drains every ring into one batch, writes the batch with a single call,
+    and naps for LOG_IDLE_WAIT microseconds whenever a pass finds nothing to do.
+    in: arg - unused
+*/
+void* runFlusher(void* arg) {
+    (void) arg;
+    char* batch = (char*) malloc(LOG_BATCH_BYTES);
+    while (C_TRUE) {
+        int running = atomic_load(&flusherRunning);
+        int used = 0;
+        pthread_mutex_lock(&ringMutex);
+        int drained = drainRings(batch, &used);
+        if (used > 0) {
+            fwrite(batch, 1, used, stdout);
+        }
+        pthread_mutex_unlock(&ringMutex);
+        if (!running && drained == 0) break;
+        if (drained == 0) {
+            usleep(LOG_IDLE_WAIT);
+        }
+    }
+    fflush(stdout);
+    free(batch);
+    return NULL;
+}
+
+/*
+    Formats the records waiting in every ring into the batch, writing the batch out whenever it fills up.
+    Rings of exited threads are freed once they are empty. The caller holds ringMutex.
+    in/out: batch - the batch buffer, LOG_BATCH_BYTES long
+    in/out: used - the number of bytes of the batch in use
+    return: the number of records drained
+*/
+int drainRings(char* batch, int* used) {
+    int drained = 0;
+    LogRing** link = &rings;
+    while (*link != NULL) {
+        LogRing* ring = *link;
+        int closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        unsigned long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            if (*used > LOG_BATCH_BYTES - 3 * MAX_STR) {
+                fwrite(batch, 1, *used, stdout);
+                *used = 0;
+            }
+            *used += formatRecord(&ring->records[tail % LOG_RING_SIZE], batch + *used, LOG_BATCH_BYTES - *used);
+            tail++;
+            drained++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        if (closed && tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            droppedTotal += atomic_load(&ring->dropped);
+            *link = ring->next;
+            free(ring);
+        }
+        else {
+            link = &ring->next;
+        }
+    }
+    return drained;
+}
+
+/*
+    Formats a record into the same line the logger has always printed.
+    in: rec - the record to format
+    out: out - the formatted line, including the newline
+    in: size - the size of out
+    return: the length of the formatted line
+*/
+int formatRecord(LogRecord* rec, char* out, int size) {
+    char str[MAX_STR];
+    const char* reason;
+    int len = 0;
+    switch (rec->event) {
+        case EVT_HUNTER_INIT:
+            evidenceToString(rec->detail, str);
+            len = snprintf(out, size, "[HUNTER INIT] [%s] is a [%s] hunter\n", rec->agent, str);
+            break;
+        case EVT_HUNTER_MOVE:
+            len = snprintf(out, size, "[HUNTER MOVE] [%s] has moved into [%s]\n", rec->agent, rec->room);
+            break;
+        case EVT_HUNTER_REVIEW:
+            reason = (rec->detail == LOG_SUFFICIENT) ? "SUFFICIENT" : (rec->detail == LOG_INSUFFICIENT) ? "INSUFFICIENT" : "UNKNOWN";
+            len = snprintf(out, size, "[HUNTER REVIEW] [%s] reviewed evidence and found [%s]\n", rec->agent, reason);
             break;
-        case LOG_BORED:
-            printf("[BORED]\n");
+        case EVT_HUNTER_COLLECT:
+            evidenceToString(rec->detail, str);
+            len = snprintf(out, size, "[HUNTER EVIDENCE] [%s] found [%s] in [%s] and [COLLECTED]\n", rec->agent, str, rec->room);
             break;
-        case LOG_EVIDENCE:
-            printf("[EVIDENCE]\n");
+        case EVT_HUNTER_EXIT:
+        case EVT_GHOST_EXIT:
+            reason = (rec->detail == LOG_FEAR) ? "FEAR" : (rec->detail == LOG_BORED) ? "BORED" : (rec->detail == LOG_EVIDENCE) ? "EVIDENCE" : "UNKNOWN";
+            if (rec->event == EVT_HUNTER_EXIT) {
+                len = snprintf(out, size, "[HUNTER EXIT] [%s] exited because [%s]\n", rec->agent, reason);
+            }
+            else if (rec->agent[0] != '\0') {
+                len = snprintf(out, size, "[GHOST EXIT] [%s] exited because [%s]\n", rec->agent, reason);
+            }
+            else {
+                len = snprintf(out, size, "[GHOST EXIT] Exited because [%s]\n", reason);
+            }
+            break;
+        //With several ghosts the record carries the ghost's name, a lone ghost is just "Ghost"
+        case EVT_GHOST_INIT:
+            ghostToString(rec->detail, str);
+            len = snprintf(out, size, "[GHOST INIT] %s is a [%s] in room [%s]\n", (rec->agent[0] != '\0') ? rec->agent : "Ghost", str, rec->room);
+            break;
+        case EVT_GHOST_MOVE:
+            len = snprintf(out, size, "[GHOST MOVE] %s has moved into [%s]\n", (rec->agent[0] != '\0') ? rec->agent : "Ghost", rec->room);
+            break;
+        case EVT_GHOST_EVIDENCE:
+            evidenceToString(rec->detail, str);
+            len = snprintf(out, size, "[GHOST EVIDENCE] %s left [%s] in [%s]\n", (rec->agent[0] != '\0') ? rec->agent : "Ghost", str, rec->room);
             break;
-        default:
-            printf("[UNKNOWN]\n");
     }
+    return (len < size) ? len : size - 1;
 }
 
 /*
-    Logs the ghost leaving evidence in a room.
-    in: evidence - the evidence type to log
-    in: room - the room name to log
+    Copies a name into a record field, cutting it at MAX_STR - 1 characters.
+    out: dest - the record field
+    in: src - the name
 */
-void l_ghostEvidence(enum EvidenceType evidence, char* room) {
-    if (!LOGGING) return;
-    char ev_str[MAX_STR];
-    evidenceToString(evidence, ev_str);
-    printf("[GHOST EVIDENCE] Ghost left [%s] in [%s]\n", ev_str, room);
+void copyName(char* dest, const char* src) {
+    int i = 0;
+    while (i < MAX_STR - 1 && src[i] != '\0') {
+        dest[i] = src[i];
+        i++;
+    }
+    dest[i] = '\0';
 }
 
 /*
-    Logs the ghost being created.
-    in: ghost - the ghost type to log
-    in: room - the room name that the ghost is starting in
-*/
-void l_ghostInit(enum GhostClass ghost, char* room) {
-    if (!LOGGING) return;
-    char ghost_str[MAX_STR];
-    ghostToString(ghost, ghost_str);
-    printf("[GHOST INIT] Ghost is a [%s] in room [%s]\n", ghost_str, room);
-}
\ No newline at end of file
+    Names a ghost for the log. A lone ghost keeps the unnamed lines the logger has always printed.
+    in: id - the ghost's id
+    in: numGhosts - the number of ghosts in the game
+    out: out - "Ghost N", or an empty string if there is only one ghost
+*/
+void ghostName(int id, int numGhosts, char* out) {
+    if (numGhosts > 1) {
+        snprintf(out, MAX_STR, "Ghost %d", id + 1);
+    }
+    else {
+        out[0] = '\0';
+    }
+}
@@ -1,16 +1,59 @@
 #include "defs.h"
 
-int main()
+int main(int argc, char* argv[])
 {   
+    Options options;
+    if(parseOptions(argc, argv, &options) == C_FALSE){
+        return 1;
+    }
+    //Instrumented builds report lock and action timings at exit and on SIGUSR1
+    INSTR_INIT();
+    //A given seed replays the same games on the virtual engine, and generates the same house
+    seedRandom(options.seed);
+    //Every game is built from the house file or the generated house if one was asked for
+    if(options.housePath != NULL && loadHouseFile(options.housePath) == C_FALSE){
+        return 1;
+    }
+    if(options.generate == C_TRUE){
+        HouseDesc desc;
+        generateHouse(&(options.genSpec), &desc);
+        if(setLoadedHouse(&desc, "generated house") == C_FALSE){
+            return 1;
+        }
+    }
+    //Every game started from here on is also written to the binary trace
+    if(options.tracePath != NULL && traceOpen(options.tracePath) == C_FALSE){
+        fprintf(stderr, "Could not create trace file '%s'\n", options.tracePath);
+        return 1;
+    }
+    //Outcome probabilities of the house, checked against a batch if --runs was given too
+    if(options.exact == C_TRUE){
+        int solved = runExact(&options);
+        traceClose();
+        unloadHouseFile();
+        return (solved == C_TRUE) ? 0 : 1;
+    }
+    //Headless batch of games, no name prompts
+    if(options.runs > 0){
+        runBatch(&options);
+        traceClose();
+        unloadHouseFile();
+        return 0;
+    }
     HouseType house;
-    Ghost ghost;
+    l_startAsync(options.logMode);
     //Initialize all elements of the program
-    initProgram(&(house), &(ghost));
-    //Threading
-    runThreads(&house, &ghost);
+    initProgram(&(house), options.hunters, options.ghosts);
+    //Threading, or the virtual time engine
+    runEngine(&house, options.engine);
+    traceEndGame(&house);
+    traceClose();
+    //Every log line has to be out before the results are printed
+    l_stopAsync();
     //Print ending
-    printEnd(house, ghost.ghostType);
+    printEnd(&house);
     //Free dynamic memory
-    freeProgram(house.rooms.head, house.sharedEvidence);
+    freeProgram(&house);
+    unloadHouseFile();
     return 0;
 }
\ No newline at end of file
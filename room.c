@@ -1,57 +1,196 @@
 #include "defs.h"
 
 /* 
-    Function: createRoom(char* roomName)
-    Purpose:  Dynamically allocates a Room and initializes all values to their default values.
+    Function: createRoom(Arena* arena, char* roomName)
+    Purpose:  Allocates a Room from the game's arena and initializes all values to their default values.
     Params:   
+        Input/Output: Arena* arena - points to the arena of the game the room belongs to.
         Input: char* roomName - stores the name of the room being created.
     Return: Room* - returns pointer to the room that was just created.
 */
-Room* createRoom(char* roomName){
-    Room* temp = malloc(sizeof(Room));
-    strcpy(temp->roomName, roomName);
-    temp->connectedRooms.head = NULL;
-    temp->connectedRooms.tail = NULL;
-    temp->connectedRooms.size = 0;
-    temp->evidenceList.head = NULL;
-    temp->evidenceList.tail = NULL;
-    temp->evidenceList.size = 0;
-    temp->ghost = NULL;
-    sem_init(&(temp->roomHunterMutex), 0, 1);
-    sem_init(&(temp->evidenceList.evidenceMutex), 0, 1);
-    sem_init(&(temp->roomGhostMutex), 0, 1);
-    for(int i = 0; i < NUM_HUNTERS; i++){
-        temp->curHunters[i] = NULL;
-    }
+Room* createRoom(Arena* arena, char* roomName){
+    Room* temp = (Room*) arenaAlloc(arena, sizeof(Room));
+    initRoom(temp, roomName);
     return temp;
 }
 
 /* 
-    Function: connectRooms(Room* room1, Room* room2)
+    Function: initRoom(Room* room, char* roomName)
+    Purpose:  Initializes all values of an already allocated Room to their default values.
+    Params:   
+        Output: Room* room - points to the room being initialized.
+        Input: char* roomName - stores the name of the room, shorter than MAX_STR.
+    Return: void
+*/
+void initRoom(Room* room, char* roomName){
+    strcpy(room->roomName, roomName);
+    room->id = -1;
+    room->graph = NULL;
+    room->connectedRooms.head = NULL;
+    room->connectedRooms.tail = NULL;
+    room->connectedRooms.size = 0;
+    for(int i = 0; i < GHOST_COUNT; i++){
+        for(int j = 0; j < EV_COUNT; j++){
+            room->evidence.counts[i][j] = 0;
+        }
+    }
+    initRoomLock(&(room->roomHunterMutex));
+    initRoomLock(&(room->evidence.evidenceMutex));
+    initRoomLock(&(room->roomGhostMutex));
+    room->hunterHead = NULL;
+    room->hunterCount = 0;
+}
+
+/*
+    Function: initOccupancy(RoomGraph* graph, Arena* arena)
+    Purpose:  Sets up the occupancy index of a compiled room graph with every room empty. The ghosts and hunters keep it up
+              to date as they enter and leave rooms, so asking whether a room has one in it is a single relaxed load.
+    Params:
+        Input/Output: RoomGraph* graph - points to the room graph, numRooms is set.
+        Input/Output: Arena* arena - points to the arena of the game the graph belongs to.
+    Return: void
+*/
+void initOccupancy(RoomGraph* graph, Arena* arena){
+    int words = (graph->numRooms + OCCUPANCY_BITS - 1) / OCCUPANCY_BITS;
+    graph->ghostCounts = (atomic_int*) arenaAlloc(arena, sizeof(atomic_int) * graph->numRooms);
+    graph->ghostRooms = (atomic_ullong*) arenaAlloc(arena, sizeof(atomic_ullong) * words);
+    graph->hunterRooms = (atomic_ullong*) arenaAlloc(arena, sizeof(atomic_ullong) * words);
+    for(int i = 0; i < graph->numRooms; i++){
+        atomic_init(&(graph->ghostCounts[i]), 0);
+    }
+    for(int i = 0; i < words; i++){
+        atomic_init(&(graph->ghostRooms[i]), 0);
+        atomic_init(&(graph->hunterRooms[i]), 0);
+    }
+}
+
+/*
+    Function: ghostEntered(Room* room)
+    Purpose:  Counts a ghost into a room, setting the room's ghost bit if it was empty. The caller holds the room's roomGhostMutex,
+              or is the only thread using the house, so the count and the bit of one room always change together.
+    Params:
+        Input: Room* room - points to the room the ghost entered.
+    Return: void
+*/
+void ghostEntered(Room* room){
+    RoomGraph* graph = room->graph;
+    if(atomic_fetch_add_explicit(&(graph->ghostCounts[room->id]), 1, memory_order_relaxed) == 0){
+        atomic_fetch_or_explicit(&(graph->ghostRooms[room->id / OCCUPANCY_BITS]), 1ULL << (room->id % OCCUPANCY_BITS), memory_order_relaxed);
+    }
+}
+
+/*
+    Function: ghostLeft(Room* room)
+    Purpose:  Counts a ghost out of a room, clearing the room's ghost bit once the last one has left. Locked as ghostEntered.
+    Params:
+        Input: Room* room - points to the room the ghost left.
+    Return: void
+*/
+void ghostLeft(Room* room){
+    RoomGraph* graph = room->graph;
+    if(atomic_fetch_sub_explicit(&(graph->ghostCounts[room->id]), 1, memory_order_relaxed) == 1){
+        atomic_fetch_and_explicit(&(graph->ghostRooms[room->id / OCCUPANCY_BITS]), ~(1ULL << (room->id % OCCUPANCY_BITS)), memory_order_relaxed);
+    }
+}
+
+/*
+    Function: nearestGhostRoom(Room* from, int* distance)
+    Purpose:  Finds the room with a ghost in it the fewest moves away, searching the room graph breadth first and testing
+              each room's bit in the ghost bitmap. Returns at once when the bitmap shows no ghost in the house at all.
+              The visited rooms and the queue come from the calling thread's arena and are released before returning.
+    Params:
+        Input: Room* from - points to the room the search starts from, which counts if a ghost is in it.
+        Output: int* distance - points to where the number of moves to the room is stored, -1 if no room has a ghost.
+    Return: Room* - returns the nearest room with a ghost, or NULL if there is none.
+*/
+Room* nearestGhostRoom(Room* from, int* distance){
+    RoomGraph* graph = from->graph;
+    int words = (graph->numRooms + OCCUPANCY_BITS - 1) / OCCUPANCY_BITS;
+    *distance = -1;
+    int anyGhost = C_FALSE;
+    for(int i = 0; i < words && anyGhost == C_FALSE; i++){
+        anyGhost = (atomic_load_explicit(&(graph->ghostRooms[i]), memory_order_relaxed) != 0) ? C_TRUE : C_FALSE;
+    }
+    if(anyGhost == C_FALSE){
+        return NULL;
+    }
+    Arena* arena = gameArena();
+    ArenaMark mark = arenaMark(arena);
+    unsigned long long* visited = (unsigned long long*) arenaAlloc(arena, sizeof(unsigned long long) * words);
+    memset(visited, 0, sizeof(unsigned long long) * words);
+    int* queue = (int*) arenaAlloc(arena, sizeof(int) * graph->numRooms);
+    int* depth = (int*) arenaAlloc(arena, sizeof(int) * graph->numRooms);
+    int head = 0, tail = 0;
+    Room* found = NULL;
+    queue[tail] = from->id;
+    depth[tail++] = 0;
+    visited[from->id / OCCUPANCY_BITS] |= 1ULL << (from->id % OCCUPANCY_BITS);
+    while(head < tail){
+        int id = queue[head];
+        int moves = depth[head++];
+        unsigned long long bit = 1ULL << (id % OCCUPANCY_BITS);
+        if((atomic_load_explicit(&(graph->ghostRooms[id / OCCUPANCY_BITS]), memory_order_relaxed) & bit) != 0){
+            found = graph->rooms[id];
+            *distance = moves;
+            break;
+        }
+        for(int i = graph->offsets[id]; i < graph->offsets[id + 1]; i++){
+            int next = graph->neighbours[i];
+            unsigned long long nextBit = 1ULL << (next % OCCUPANCY_BITS);
+            if((visited[next / OCCUPANCY_BITS] & nextBit) == 0){
+                visited[next / OCCUPANCY_BITS] |= nextBit;
+                queue[tail] = next;
+                depth[tail++] = moves + 1;
+            }
+        }
+    }
+    arenaRelease(arena, mark);
+    return found;
+}
+
+/* 
+    Function: initRoomLock(RoomLock* lock)
+    Purpose:  Initializes one of a room's mutexes. An instrumented build attaches its statistics once the game is set up.
+    Params:   
+        Output: RoomLock* lock - points to the lock being initialized.
+    Return: void
+*/
+void initRoomLock(RoomLock* lock){
+    pthread_mutex_init(&(lock->mutex), NULL);
+#ifdef INSTRUMENT
+    lock->stats = NULL;
+    lock->lockedAt = 0;
+#endif
+}
+
+/* 
+    Function: connectRooms(Arena* arena, Room* room1, Room* room2)
     Purpose:  Connects the two given rooms.
     Params:   
+        Input/Output: Arena* arena - points to the arena of the game the rooms belong to.
         Input/Output: Room* room1 - points to the first of the two rooms being connected.
         Input/Output: Room* room2 - points to the second of the two rooms being connected.
     Return: void
 */
-void connectRooms(Room* room1, Room* room2) {
+void connectRooms(Arena* arena, Room* room1, Room* room2) {
     //Connects the second room to the first
-    addRoom(&(room1->connectedRooms), room2);
+    addRoom(arena, &(room1->connectedRooms), room2);
     //Connects the first room to the second
-    addRoom(&(room2->connectedRooms), room1);
+    addRoom(arena, &(room2->connectedRooms), room1);
 }
 
 /* 
-    Function: addRoom(RoomList* roomList, Room* room)
+    Function: addRoom(Arena* arena, RoomList* roomList, Room* room)
     Purpose:  Adds a given room to a list of rooms.
     Params:   
+        Input/Output: Arena* arena - points to the arena of the game the list belongs to.
         Input/Output: RoomList* roomList - points to the list where the room is being added.
         Input: Room* room1 - points to the room being added to the roomlist.
     Return: void
 */
-void addRoom(RoomList* roomList, Room* room){
+void addRoom(Arena* arena, RoomList* roomList, Room* room){
     //Initialize new room node
-    RoomNode* new = (RoomNode*) malloc(sizeof(RoomNode));
+    RoomNode* new = (RoomNode*) arenaAlloc(arena, sizeof(RoomNode));
     new->data = room;
     new->next = NULL;
 
@@ -0,0 +1,157 @@
+#include "defs.h"
+
+/*
+    Function: runTick(HouseType* house)
+    Purpose:  Runs a whole game on the calling thread in lock step. All hunters share one cadence and all ghosts another, so
+              instead of a queue of wake-ups every HUNTER_WAIT the hunters take their turn together: the kernel checks fear
+              and boredom for all of them at once, then the hunters that stay act one by one.
+              Ghost turns due before the hunters' turn go first, and the hunters go first on ties as on the virtual engine,
+              which is why a seed gives the same games on both engines. The game stops after the hunters' turn that decides it.
+    Params:
+        Input/Output: HouseType* house - points to the house storing all of the hunters and ghosts.
+    Return: long - returns the simulated time in microseconds at which the game's outcome was decided.
+*/
+long runTick(HouseType* house){
+    HunterSoA soa;
+    initHunterSoA(&soa, house);
+    int ghostsLeft = house->numGhosts;
+    char* ghostGone = (char*) arenaAlloc(house->arena, house->numGhosts);
+    memset(ghostGone, 0, house->numGhosts);
+    long hunterTime = HUNTER_WAIT;
+    long ghostTime = GHOST_WAIT;
+    long now = 0;
+    int over = C_FALSE;
+    while(over == C_FALSE){
+        if(ghostsLeft > 0 && ghostTime < hunterTime){
+            now = ghostTime;
+            house->now = now;
+            for(int i = 0; i < house->numGhosts; i++){
+                if(ghostGone[i] == C_TRUE){
+                    continue;
+                }
+                Ghost* ghost = &(house->curGhosts[i]);
+                Room* before = ghost->curRoom;
+                rngUse(&(ghost->rng));
+                if(ghostStep(ghost) == C_TRUE){
+                    ghostGone[i] = C_TRUE;
+                    ghostsLeft--;
+                }
+                soa.roomGhosts[before->id]--;
+                soa.roomGhosts[ghost->curRoom->id]++;
+            }
+            ghostTime += GHOST_WAIT;
+            continue;
+        }
+        now = hunterTime;
+        house->now = now;
+        //Fear and boredom of every hunter in one pass, then the hunters it sent home leave
+        if(tickKernel(&soa) == C_TRUE){
+            for(int i = 0; i < soa.count; i++){
+                if(soa.leaving[i] != 0){
+                    l_hunterExit(&(house->curHunters[i]), (soa.fear[i] >= FEAR_MAX) ? LOG_FEAR : LOG_BORED);
+                    removeHunter(&(house->curHunters[i]));
+                    //hunterLeft tells why the hunter left from its fear and boredom
+                    house->curHunters[i].fear = soa.fear[i];
+                    house->curHunters[i].boredom = soa.boredom[i];
+                    over |= hunterLeft(house, &(house->curHunters[i]));
+                }
+            }
+        }
+        for(int i = 0; i < soa.count; i++){
+            if(soa.alive[i] == 0){
+                continue;
+            }
+            Hunter* hunter = &(house->curHunters[i]);
+            rngUse(&(hunter->rng));
+            if(hunterAct(hunter) == C_TRUE){
+                removeHunter(hunter);
+                over |= hunterLeft(house, hunter);
+                soa.alive[i] = 0;
+            }
+            soa.room[i] = hunter->curRoom->id;
+        }
+        hunterTime += HUNTER_WAIT;
+    }
+    rngUse(NULL);
+    //The results are read from the hunters
+    for(int i = 0; i < soa.count; i++){
+        house->curHunters[i].fear = soa.fear[i];
+        house->curHunters[i].boredom = soa.boredom[i];
+    }
+    return now;
+}
+
+/*
+    Function: initHunterSoA(HunterSoA* soa, HouseType* house)
+    Purpose:  Copies the hot state of a game's hunters into one aligned allocation of padded arrays, and the number of
+              ghosts in every room into roomGhosts. Both come from the game's arena and are freed with the game.
+    Params:
+        Output: HunterSoA* soa - points to the arrays being set up.
+        Input: HouseType* house - points to an initialized game.
+    Return: void
+*/
+void initHunterSoA(HunterSoA* soa, HouseType* house){
+    soa->count = house->numHunters;
+    soa->padded = (house->numHunters + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+    size_t bytes = sizeof(int) * soa->padded;
+    int* block = (int*) arenaAlloc(house->arena, bytes * 5);
+    memset(block, 0, bytes * 5);
+    soa->room = block;
+    soa->fear = block + soa->padded;
+    soa->boredom = block + 2 * soa->padded;
+    soa->alive = block + 3 * soa->padded;
+    soa->leaving = block + 4 * soa->padded;
+    for(int i = 0; i < soa->count; i++){
+        Hunter* hunter = &(house->curHunters[i]);
+        soa->room[i] = hunter->curRoom->id;
+        soa->fear[i] = hunter->fear;
+        soa->boredom[i] = hunter->boredom;
+        soa->alive[i] = -1;
+    }
+    RoomGraph* graph = &(house->graph);
+    soa->roomGhosts = (int*) arenaAlloc(house->arena, sizeof(int) * graph->numRooms);
+    for(int i = 0; i < graph->numRooms; i++){
+        soa->roomGhosts[i] = atomic_load_explicit(&(graph->ghostCounts[i]), memory_order_relaxed);
+    }
+}
+
+/*
+    Function: tickKernel(HunterSoA* soa)
+    Purpose:  Does isHunterleaving's fear and boredom update for every hunter, SOA_LANES at a time and without branches:
+              a ghost raises fear and resets boredom, an empty room raises boredom, and a hunter leaves once fear
+              reaches FEAR_MAX or boredom reaches BOREDOM_MAX. Hunters that already left keep their state.
+              The ghost counts come from roomGhosts rather than the rooms, so nothing is locked and no Room is touched.
+    Params:
+        Input/Output: HunterSoA* soa - points to the hunters. Leaving hunters are marked in leaving and cleared in alive.
+    Return: int - returns C_TRUE if any hunter is leaving, or C_FALSE otherwise
+*/
+int tickKernel(HunterSoA* soa){
+    SoaVec anyLeaving = {0};
+    for(int i = 0; i < soa->padded; i += SOA_LANES){
+        SoaVec alive = *(SoaVec*) &(soa->alive[i]);
+        SoaVec fear = *(SoaVec*) &(soa->fear[i]);
+        SoaVec boredom = *(SoaVec*) &(soa->boredom[i]);
+        SoaVec ghosts;
+        for(int lane = 0; lane < SOA_LANES; lane++){
+            ghosts[lane] = soa->roomGhosts[soa->room[i + lane]];
+        }
+        //Hunters that left are not scared any more
+        ghosts &= alive;
+        //-1 in the lanes of hunters sharing their room with a ghost, 0 elsewhere
+        SoaVec haunted = ghosts > 0;
+        fear += ghosts * FEAR_INCREMENT;
+        boredom = ((boredom + 1) & ~haunted & alive) | (boredom & ~alive);
+        SoaVec leaving = alive & ((fear >= FEAR_MAX) | (boredom == BOREDOM_MAX));
+        *(SoaVec*) &(soa->fear[i]) = fear;
+        *(SoaVec*) &(soa->boredom[i]) = boredom;
+        *(SoaVec*) &(soa->alive[i]) = alive & ~leaving;
+        *(SoaVec*) &(soa->leaving[i]) = leaving;
+        anyLeaving |= leaving;
+    }
+    for(int lane = 0; lane < SOA_LANES; lane++){
+        if(anyLeaving[lane] != 0){
+            return C_TRUE;
+        }
+    }
+    return C_FALSE;
+}
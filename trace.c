@@ -0,0 +1,226 @@
+#include "defs.h"
+
+//Forward declarations
+void traceReserve(TraceBuffer* trace, long bytes);
+void tracePutByte(TraceBuffer* trace, unsigned char byte);
+void tracePutVarint(TraceBuffer* trace, unsigned long value);
+void tracePutName(TraceBuffer* trace, const char* name);
+
+//Games finish on several workers at once, each appends its whole buffer while holding fileMutex
+static FILE* traceFile = NULL;
+static pthread_mutex_t fileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+    Function: traceOpen(char* path)
+    Purpose:  Creates the binary trace file and writes its header. Games started afterwards are traced.
+    Params:
+        Input: char* path - stores the path of the trace file.
+    Return: int - returns C_TRUE if the file was created, or C_FALSE otherwise
+*/
+int traceOpen(char* path){
+    traceFile = fopen(path, "wb");
+    if(traceFile == NULL){
+        return C_FALSE;
+    }
+    fwrite(TRACE_MAGIC, 1, 4, traceFile);
+    fputc(TRACE_VERSION, traceFile);
+    return C_TRUE;
+}
+
+/*
+    Function: traceClose()
+    Purpose:  Closes the binary trace file. Every traced game has to have ended.
+    Return: void
+*/
+void traceClose(){
+    if(traceFile != NULL){
+        fclose(traceFile);
+        traceFile = NULL;
+    }
+}
+
+/*
+    Function: traceBeginGame(HouseType* house, int runId, char hunterNames[][MAX_STR])
+    Purpose:  Starts tracing a game if a trace file is open. The game header holds the room and hunter names and the number of ghosts once,
+              so every event after it only needs their ids. Call it before the agents are initialized.
+    Params:
+        Input/Output: HouseType* house - points to a compiled house with its hunter and ghost counts set, its trace buffer is created here.
+        Input: int runId - stores the id of the run, so the games of a batch can be told apart.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters, indexed by hunter id.
+    Return: void
+*/
+void traceBeginGame(HouseType* house, int runId, char hunterNames[][MAX_STR]){
+    if(traceFile == NULL){
+        return;
+    }
+    TraceBuffer* trace = (TraceBuffer*) malloc(sizeof(TraceBuffer));
+    trace->data = (unsigned char*) malloc(TRACE_INITIAL_BYTES);
+    trace->size = 0;
+    trace->capacity = TRACE_INITIAL_BYTES;
+    trace->lastTime = 0;
+    pthread_mutex_init(&(trace->mutex), NULL);
+    tracePutByte(trace, TRACE_GAME_BEGIN);
+    tracePutVarint(trace, runId);
+    tracePutVarint(trace, house->graph.numRooms);
+    for(int i = 0; i < house->graph.numRooms; i++){
+        tracePutName(trace, house->graph.rooms[i]->roomName);
+    }
+    tracePutVarint(trace, house->numHunters);
+    for(int i = 0; i < house->numHunters; i++){
+        tracePutName(trace, hunterNames[i]);
+    }
+    tracePutVarint(trace, house->numGhosts);
+    house->trace = trace;
+}
+
+/*
+    Function: traceEndGame(HouseType* house)
+    Purpose:  Closes the game's trace and appends it to the trace file. Every agent has to have stopped.
+    Params:
+        Input/Output: HouseType* house - points to the house, its trace buffer is freed here.
+    Return: void
+*/
+void traceEndGame(HouseType* house){
+    TraceBuffer* trace = house->trace;
+    if(trace == NULL){
+        return;
+    }
+    tracePutByte(trace, TRACE_GAME_END);
+    pthread_mutex_lock(&fileMutex);
+    fwrite(trace->data, 1, trace->size, traceFile);
+    pthread_mutex_unlock(&fileMutex);
+    pthread_mutex_destroy(&(trace->mutex));
+    free(trace->data);
+    free(trace);
+    house->trace = NULL;
+}
+
+/*
+    Function: traceRecord(HouseType* house, LogRecord* rec)
+    Purpose:  Encodes one event into the game's trace: a tag byte holding the event and a small agent id, the time since
+              the previous event as a varint, then the detail byte and the room id only for the events that have them.
+    Params:
+        Input/Output: HouseType* house - points to the house of the game being traced.
+        Input: LogRecord* rec - points to the event.
+    Return: void
+*/
+void traceRecord(HouseType* house, LogRecord* rec){
+    TraceBuffer* trace = house->trace;
+    pthread_mutex_lock(&(trace->mutex));
+    //The clock is read under the lock so the deltas of a threaded game never go negative
+    long time = gameTime(house);
+    long delta = (time > trace->lastTime) ? time - trace->lastTime : 0;
+    trace->lastTime += delta;
+    //Event in the high nibble of the tag, and the agent id in the low nibble unless it needs a varint of its own
+    if(rec->agentId < TRACE_AGENT_ESCAPE){
+        tracePutByte(trace, TRACE_EVENT * (rec->event + 1) + rec->agentId);
+        tracePutVarint(trace, delta);
+    }
+    else{
+        tracePutByte(trace, TRACE_EVENT * (rec->event + 1) + TRACE_AGENT_ESCAPE);
+        tracePutVarint(trace, delta);
+        tracePutVarint(trace, rec->agentId);
+    }
+    if(traceEventHasDetail(rec->event) == C_TRUE){
+        tracePutByte(trace, (unsigned char) rec->detail);
+    }
+    if(traceEventHasRoom(rec->event) == C_TRUE){
+        tracePutVarint(trace, rec->roomId);
+    }
+    pthread_mutex_unlock(&(trace->mutex));
+}
+
+/*
+    Function: traceEventHasDetail(enum LogEvent event)
+    Purpose:  Tells whether the trace stores a detail byte (evidence, ghost type or reason) for an event.
+    Params:
+        Input: enum LogEvent event - stores the event.
+    Return: int - returns C_TRUE if the event has a detail byte, or C_FALSE otherwise
+*/
+int traceEventHasDetail(enum LogEvent event){
+    return (event != EVT_HUNTER_MOVE && event != EVT_GHOST_MOVE) ? C_TRUE : C_FALSE;
+}
+
+/*
+    Function: traceEventHasRoom(enum LogEvent event)
+    Purpose:  Tells whether the trace stores a room id for an event.
+    Params:
+        Input: enum LogEvent event - stores the event.
+    Return: int - returns C_TRUE if the event has a room id, or C_FALSE otherwise
+*/
+int traceEventHasRoom(enum LogEvent event){
+    switch(event){
+        case EVT_HUNTER_MOVE:
+        case EVT_HUNTER_COLLECT:
+        case EVT_GHOST_INIT:
+        case EVT_GHOST_MOVE:
+        case EVT_GHOST_EVIDENCE:
+            return C_TRUE;
+        default:
+            return C_FALSE;
+    }
+}
+
+/*
+    Function: traceReserve(TraceBuffer* trace, long bytes)
+    Purpose:  Grows a trace buffer so the given number of bytes can be appended.
+    Params:
+        Input/Output: TraceBuffer* trace - points to the buffer.
+        Input: long bytes - stores the number of bytes about to be appended.
+    Return: void
+*/
+void traceReserve(TraceBuffer* trace, long bytes){
+    if(trace->size + bytes <= trace->capacity){
+        return;
+    }
+    while(trace->size + bytes > trace->capacity){
+        trace->capacity *= 2;
+    }
+    trace->data = (unsigned char*) realloc(trace->data, trace->capacity);
+}
+
+/*
+    Function: tracePutByte(TraceBuffer* trace, unsigned char byte)
+    Purpose:  Appends one byte to a trace buffer.
+    Params:
+        Input/Output: TraceBuffer* trace - points to the buffer.
+        Input: unsigned char byte - stores the byte.
+    Return: void
+*/
+void tracePutByte(TraceBuffer* trace, unsigned char byte){
+    traceReserve(trace, 1);
+    trace->data[trace->size++] = byte;
+}
+
+/*
+    Function: tracePutVarint(TraceBuffer* trace, unsigned long value)
+    Purpose:  Appends a number as a varint, 7 bits per byte with the high bit set on every byte but the last.
+    Params:
+        Input/Output: TraceBuffer* trace - points to the buffer.
+        Input: unsigned long value - stores the number.
+    Return: void
+*/
+void tracePutVarint(TraceBuffer* trace, unsigned long value){
+    traceReserve(trace, 10);
+    while(value >= 0x80){
+        trace->data[trace->size++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    trace->data[trace->size++] = (unsigned char) value;
+}
+
+/*
+    Function: tracePutName(TraceBuffer* trace, const char* name)
+    Purpose:  Appends a name as its length followed by its characters.
+    Params:
+        Input/Output: TraceBuffer* trace - points to the buffer.
+        Input: const char* name - stores the name.
+    Return: void
+*/
+void tracePutName(TraceBuffer* trace, const char* name){
+    long length = strlen(name);
+    tracePutVarint(trace, length);
+    traceReserve(trace, length);
+    memcpy(trace->data + trace->size, name, length);
+    trace->size += length;
+}
@@ -0,0 +1,444 @@
+#include "defs.h"
+
+//Position in a trace file loaded into memory
+typedef struct TraceReader {
+    unsigned char* data;
+    long size;
+    long pos;
+} TraceReader;
+
+//Names from a game header, indexed by room id and hunter id
+typedef struct TraceGame {
+    int runId;
+    int numRooms;
+    int numHunters;
+    int numGhosts;
+    char (*roomNames)[MAX_STR];
+    char (*hunterNames)[MAX_STR];
+} TraceGame;
+
+//Per-room state rebuilt by replaying a game's events
+typedef struct ReplayState {
+    int* ghostRooms;            //Indexed by ghost id, -1 before the ghost is created and after it leaves
+    int* hunterRooms;           //Indexed by hunter id, -1 if the hunter is not in the house
+    int (*evidence)[EV_COUNT];  //Evidence lying in each room, indexed by room id
+    unsigned int found;         //Evidence types the hunters have collected
+} ReplayState;
+
+//Forward declarations
+int readTrace(char* path, TraceReader* reader);
+int readByte(TraceReader* reader, int* value);
+int readVarint(TraceReader* reader, long* value);
+int readName(TraceReader* reader, char* name);
+int readGameHeader(TraceReader* reader, TraceGame* game);
+int readEvent(TraceReader* reader, TraceGame* game, LogRecord* rec, long* time);
+void freeGame(TraceGame* game);
+void applyEvent(ReplayState* state, LogRecord* rec);
+void printState(ReplayState* state, TraceGame* game, long events, long time);
+int processTrace(TraceReader* reader, int replay, int gameId, long offset);
+
+/*
+    Decodes a binary trace back into the text log, or replays one of its games up to an event offset.
+*/
+int main(int argc, char* argv[])
+{
+    if(argc < 3 || (strcmp(argv[1], "decode") != 0 && strcmp(argv[1], "replay") != 0)){
+        fprintf(stderr, "Usage: %s decode FILE [--game N]\n       %s replay FILE --offset K [--game N]\n", argv[0], argv[0]);
+        return 1;
+    }
+    int replay = (strcmp(argv[1], "replay") == 0);
+    int gameId = -1;
+    long offset = -1;
+    for(int i = 3; i < argc; i++){
+        if(strcmp(argv[i], "--game") == 0 && i + 1 < argc){
+            gameId = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--offset") == 0 && i + 1 < argc){
+            offset = atol(argv[++i]);
+        }
+        else{
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if(replay && offset < 0){
+        fprintf(stderr, "replay needs --offset K, the number of events to apply\n");
+        return 1;
+    }
+    TraceReader reader;
+    if(readTrace(argv[2], &reader) == C_FALSE){
+        return 1;
+    }
+    int ok = processTrace(&reader, replay, gameId, offset);
+    free(reader.data);
+    return ok ? 0 : 1;
+}
+
+/*
+    Function: processTrace(TraceReader* reader, int replay, int gameId, long offset)
+    Purpose:  Walks every game of a trace, printing the text log of the selected games, or replaying the selected game.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace, positioned after the file header.
+        Input: int replay - C_TRUE to replay, C_FALSE to decode.
+        Input: int gameId - stores the run id of the game to use, or -1 for every game (decode) or the first one (replay).
+        Input: long offset - stores the number of events to replay.
+    Return: int - returns C_TRUE if the trace was read without errors, or C_FALSE otherwise
+*/
+int processTrace(TraceReader* reader, int replay, int gameId, long offset){
+    char line[3 * MAX_STR];
+    int tag;
+    while(readByte(reader, &tag) == C_TRUE){
+        TraceGame game;
+        if(tag != TRACE_GAME_BEGIN || readGameHeader(reader, &game) == C_FALSE){
+            fprintf(stderr, "Corrupt trace at byte %ld\n", reader->pos);
+            return C_FALSE;
+        }
+        int selected = (gameId < 0 || gameId == game.runId);
+        ReplayState state;
+        if(replay && selected){
+            state.ghostRooms = (int*) malloc(sizeof(int) * game.numGhosts);
+            for(int i = 0; i < game.numGhosts; i++){
+                state.ghostRooms[i] = -1;
+            }
+            state.hunterRooms = (int*) malloc(sizeof(int) * game.numHunters);
+            for(int i = 0; i < game.numHunters; i++){
+                state.hunterRooms[i] = -1;
+            }
+            state.evidence = calloc(game.numRooms, sizeof(*state.evidence));
+            state.found = 0;
+        }
+        long events = 0;
+        long time = 0;
+        LogRecord rec;
+        int status;
+        while((status = readEvent(reader, &game, &rec, &time)) == C_TRUE){
+            if(selected && !replay){
+                fwrite(line, 1, formatRecord(&rec, line, sizeof(line)), stdout);
+            }
+            else if(selected && events < offset){
+                applyEvent(&state, &rec);
+            }
+            events++;
+        }
+        if(replay && selected){
+            printState(&state, &game, (events < offset) ? events : offset, time);
+            free(state.ghostRooms);
+            free(state.hunterRooms);
+            free(state.evidence);
+        }
+        freeGame(&game);
+        if(status < 0){
+            fprintf(stderr, "Corrupt trace at byte %ld\n", reader->pos);
+            return C_FALSE;
+        }
+        if(replay && selected){
+            return C_TRUE;
+        }
+    }
+    if(replay){
+        fprintf(stderr, "Game %d is not in the trace\n", gameId);
+        return C_FALSE;
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: readEvent(TraceReader* reader, TraceGame* game, LogRecord* rec, long* time)
+    Purpose:  Reads the next event of a game and turns it back into the record the logger built.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace.
+        Input: TraceGame* game - points to the game header, used to put the names back.
+        Output: LogRecord* rec - points to the decoded record.
+        Input/Output: long* time - stores the game time of the previous event, and then of this one.
+    Return: int - returns C_TRUE if an event was read, C_FALSE at the end of the game, or -1 if the trace is corrupt
+*/
+int readEvent(TraceReader* reader, TraceGame* game, LogRecord* rec, long* time){
+    int tag;
+    if(readByte(reader, &tag) == C_FALSE){
+        return -1;
+    }
+    if(tag == TRACE_GAME_END){
+        return C_FALSE;
+    }
+    if(tag < TRACE_EVENT || tag >= TRACE_EVENT * (EVT_GHOST_EXIT + 2)){
+        return -1;
+    }
+    long delta, agentId = tag % TRACE_EVENT, roomId = -1;
+    int detail = 0;
+    rec->event = tag / TRACE_EVENT - 1;
+    if(readVarint(reader, &delta) == C_FALSE){
+        return -1;
+    }
+    if(agentId == TRACE_AGENT_ESCAPE && readVarint(reader, &agentId) == C_FALSE){
+        return -1;
+    }
+    if(traceEventHasDetail(rec->event) == C_TRUE && readByte(reader, &detail) == C_FALSE){
+        return -1;
+    }
+    if(traceEventHasRoom(rec->event) == C_TRUE && (readVarint(reader, &roomId) == C_FALSE || roomId >= game->numRooms)){
+        return -1;
+    }
+    if((rec->event == EVT_HUNTER_COLLECT || rec->event == EVT_GHOST_EVIDENCE) && detail >= EV_COUNT){
+        return -1;
+    }
+    *time += delta;
+    rec->detail = detail;
+    rec->agentId = (int) agentId;
+    rec->roomId = (int) roomId;
+    rec->agent[0] = '\0';
+    rec->room[0] = '\0';
+    if(rec->event <= EVT_HUNTER_EXIT){
+        if(agentId >= game->numHunters){
+            return -1;
+        }
+        strcpy(rec->agent, game->hunterNames[agentId]);
+    }
+    else if(agentId >= game->numGhosts){
+        return -1;
+    }
+    else{
+        ghostName((int) agentId, game->numGhosts, rec->agent);
+    }
+    if(roomId >= 0){
+        strcpy(rec->room, game->roomNames[roomId]);
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: applyEvent(ReplayState* state, LogRecord* rec)
+    Purpose:  Applies one event to the replayed state of a game.
+    Params:
+        Input/Output: ReplayState* state - points to the replayed state.
+        Input: LogRecord* rec - points to the event.
+    Return: void
+*/
+void applyEvent(ReplayState* state, LogRecord* rec){
+    switch(rec->event){
+        case EVT_HUNTER_INIT:
+            //Hunters start in the Van, which is always room 0
+            state->hunterRooms[rec->agentId] = 0;
+            break;
+        case EVT_HUNTER_MOVE:
+            state->hunterRooms[rec->agentId] = rec->roomId;
+            break;
+        case EVT_HUNTER_COLLECT:
+            state->evidence[rec->roomId][rec->detail]--;
+            state->found |= 1u << rec->detail;
+            break;
+        case EVT_HUNTER_EXIT:
+            state->hunterRooms[rec->agentId] = -1;
+            break;
+        case EVT_GHOST_INIT:
+        case EVT_GHOST_MOVE:
+            state->ghostRooms[rec->agentId] = rec->roomId;
+            break;
+        case EVT_GHOST_EVIDENCE:
+            state->evidence[rec->roomId][rec->detail]++;
+            break;
+        case EVT_GHOST_EXIT:
+            state->ghostRooms[rec->agentId] = -1;
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+    Function: printState(ReplayState* state, TraceGame* game, long events, long time)
+    Purpose:  Prints the replayed state of every room, and the evidence the hunters have collected.
+    Params:
+        Input: ReplayState* state - points to the replayed state.
+        Input: TraceGame* game - points to the game header.
+        Input: long events - stores the number of events that were applied.
+        Input: long time - stores the game time at the end of the game.
+    Return: void
+*/
+void printState(ReplayState* state, TraceGame* game, long events, long time){
+    char str[MAX_STR];
+    printf("Game %d after %ld events (game ended at %ld us)\n", game->runId, events, time);
+    for(int room = 0; room < game->numRooms; room++){
+        printf("    [%s]", game->roomNames[room]);
+        for(int i = 0; i < game->numGhosts; i++){
+            if(state->ghostRooms[i] == room && game->numGhosts == 1){
+                printf(" ghost");
+            }
+            else if(state->ghostRooms[i] == room){
+                printf(" [Ghost %d]", i + 1);
+            }
+        }
+        for(int i = 0; i < game->numHunters; i++){
+            if(state->hunterRooms[i] == room){
+                printf(" [%s]", game->hunterNames[i]);
+            }
+        }
+        for(int ev = 0; ev < EV_COUNT; ev++){
+            if(state->evidence[room][ev] > 0){
+                evidenceToString(ev, str);
+                printf(" %s x%d", str, state->evidence[room][ev]);
+            }
+        }
+        printf("\n");
+    }
+    printf("    Collected:");
+    for(int ev = 0; ev < EV_COUNT; ev++){
+        if(state->found & (1u << ev)){
+            evidenceToString(ev, str);
+            printf(" %s", str);
+        }
+    }
+    printf("\n");
+}
+
+/*
+    Function: readGameHeader(TraceReader* reader, TraceGame* game)
+    Purpose:  Reads the run id, the room and hunter names and the number of ghosts that start every game.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace, positioned after the game's tag.
+        Output: TraceGame* game - points to the game header, its name arrays are allocated here.
+    Return: int - returns C_TRUE if the header was read, or C_FALSE if the trace is corrupt
+*/
+int readGameHeader(TraceReader* reader, TraceGame* game){
+    long runId, numRooms, numHunters, numGhosts;
+    game->roomNames = NULL;
+    game->hunterNames = NULL;
+    if(readVarint(reader, &runId) == C_FALSE || readVarint(reader, &numRooms) == C_FALSE || numRooms > reader->size){
+        return C_FALSE;
+    }
+    game->runId = (int) runId;
+    game->numRooms = (int) numRooms;
+    game->roomNames = malloc(sizeof(*game->roomNames) * numRooms);
+    for(int i = 0; i < numRooms; i++){
+        if(readName(reader, game->roomNames[i]) == C_FALSE){
+            freeGame(game);
+            return C_FALSE;
+        }
+    }
+    if(readVarint(reader, &numHunters) == C_FALSE || numHunters > reader->size){
+        freeGame(game);
+        return C_FALSE;
+    }
+    game->numHunters = (int) numHunters;
+    game->hunterNames = malloc(sizeof(*game->hunterNames) * numHunters);
+    for(int i = 0; i < numHunters; i++){
+        if(readName(reader, game->hunterNames[i]) == C_FALSE){
+            freeGame(game);
+            return C_FALSE;
+        }
+    }
+    if(readVarint(reader, &numGhosts) == C_FALSE || numGhosts > reader->size){
+        freeGame(game);
+        return C_FALSE;
+    }
+    game->numGhosts = (int) numGhosts;
+    return C_TRUE;
+}
+
+/*
+    Function: freeGame(TraceGame* game)
+    Purpose:  Frees the name arrays of a game header.
+    Params:
+        Input/Output: TraceGame* game - points to the game header.
+    Return: void
+*/
+void freeGame(TraceGame* game){
+    free(game->roomNames);
+    free(game->hunterNames);
+    game->roomNames = NULL;
+    game->hunterNames = NULL;
+}
+
+/*
+    Function: readTrace(char* path, TraceReader* reader)
+    Purpose:  Loads a whole trace file into memory and checks its header.
+    Params:
+        Input: char* path - stores the path of the trace file.
+        Output: TraceReader* reader - points to the loaded trace, positioned after the file header.
+    Return: int - returns C_TRUE if the file was loaded, or C_FALSE otherwise
+*/
+int readTrace(char* path, TraceReader* reader){
+    FILE* file = fopen(path, "rb");
+    if(file == NULL){
+        fprintf(stderr, "Could not open trace file '%s'\n", path);
+        return C_FALSE;
+    }
+    fseek(file, 0, SEEK_END);
+    reader->size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    reader->data = (unsigned char*) malloc(reader->size > 0 ? reader->size : 1);
+    reader->pos = 0;
+    long got = fread(reader->data, 1, reader->size, file);
+    fclose(file);
+    int version;
+    if(got != reader->size || reader->size < 4 || memcmp(reader->data, TRACE_MAGIC, 4) != 0){
+        fprintf(stderr, "'%s' is not a trace file\n", path);
+        free(reader->data);
+        return C_FALSE;
+    }
+    reader->pos = 4;
+    if(readByte(reader, &version) == C_FALSE || version != TRACE_VERSION){
+        fprintf(stderr, "'%s' has an unsupported trace version\n", path);
+        free(reader->data);
+        return C_FALSE;
+    }
+    return C_TRUE;
+}
+
+/*
+    Function: readByte(TraceReader* reader, int* value)
+    Purpose:  Reads one byte of the trace.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace.
+        Output: int* value - stores the byte.
+    Return: int - returns C_TRUE if a byte was read, or C_FALSE at the end of the trace
+*/
+int readByte(TraceReader* reader, int* value){
+    if(reader->pos >= reader->size){
+        return C_FALSE;
+    }
+    *value = reader->data[reader->pos++];
+    return C_TRUE;
+}
+
+/*
+    Function: readVarint(TraceReader* reader, long* value)
+    Purpose:  Reads a varint written by tracePutVarint.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace.
+        Output: long* value - stores the number.
+    Return: int - returns C_TRUE if a number was read, or C_FALSE if the trace ends in the middle of it
+*/
+int readVarint(TraceReader* reader, long* value){
+    unsigned long result = 0;
+    int byte;
+    for(int shift = 0; shift < 63; shift += 7){
+        if(readByte(reader, &byte) == C_FALSE){
+            return C_FALSE;
+        }
+        result |= (unsigned long) (byte & 0x7f) << shift;
+        if((byte & 0x80) == 0){
+            *value = (long) result;
+            return C_TRUE;
+        }
+    }
+    return C_FALSE;
+}
+
+/*
+    Function: readName(TraceReader* reader, char* name)
+    Purpose:  Reads a name written by tracePutName.
+    Params:
+        Input/Output: TraceReader* reader - points to the trace.
+        Output: char* name - stores the name, MAX_STR long.
+    Return: int - returns C_TRUE if the name was read, or C_FALSE if the trace is corrupt
+*/
+int readName(TraceReader* reader, char* name){
+    long length;
+    if(readVarint(reader, &length) == C_FALSE || length >= MAX_STR || reader->pos + length > reader->size){
+        return C_FALSE;
+    }
+    memcpy(name, reader->data + reader->pos, length);
+    name[length] = '\0';
+    reader->pos += length;
+    return C_TRUE;
+}
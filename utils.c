@@ -1,33 +1,149 @@
 #include "defs.h"
 
+//Forward declarations
+Rng* threadRng();
+uint64_t splitMix(uint64_t x);
+uint64_t rotateLeft(uint64_t x, int k);
+
+static unsigned int baseSeed = 0;
+static unsigned int nextStream = 0;
+static __thread Rng* currentRng = NULL;
+
 /*
     Returns a pseudo randomly generated number, in the range min to (max - 1), inclusively
         in:   lower end of the range of the generated number
         in:   upper end of the range of the generated number
-    return:   randomly generated integer in the range [0, max-1) 
+    return:   randomly generated integer in the range [min, max), or min if the range is empty
 */
 int randInt(int min, int max)
 {
-    return (int) randFloat(min, max);
+    if (max <= min) {
+        return min;
+    }
+    return min + (int) rngBelow(threadRng(), (uint32_t) (max - min));
 }
 
 /*
     Returns a pseudo randomly generated floating point number.
-    A few tricks to make this thread safe, just to reduce any chance of issues using random
         in:   lower end of the range of the generated number
         in:   upper end of the range of the generated number
     return:   randomly generated floating point number in the range [min, max)
 */
 float randFloat(float min, float max) {
-    static __thread unsigned int seed = 0;
-    if (seed == 0) {
-        seed = (unsigned int)time(NULL) ^ (unsigned int)pthread_self();
+    //24 random bits fill a float's mantissa exactly, so the result never rounds up to max
+    float random = (float) (rngNext(threadRng()) >> 40) * (1.0f / 16777216.0f);
+    return min + random * (max - min);
+}
+
+/*
+    Sets the base seed that every stream is derived from.
+    The same seed replays the same games on the single-threaded engines, whatever the number of workers.
+        in:   seed - the base seed
+*/
+void seedRandom(unsigned int seed) {
+    baseSeed = seed;
+}
+
+/*
+    Seeds the stream of one agent of one run. Streams are keyed by (base seed, run id, stream), so workers
+    never have to coordinate to get independent streams.
+        out:  rng - the stream to seed
+        in:   runId - the id of the run
+        in:   stream - RNG_STREAM_HOUSE, RNG_STREAM_HUNTER + hunter id or RNG_STREAM_GHOST + ghost id
+*/
+void rngInit(Rng* rng, int runId, int stream) {
+    uint64_t key = splitMix(baseSeed);
+    key = splitMix(key ^ (uint32_t) runId);
+    key = splitMix(key ^ (uint32_t) stream);
+    for (int i = 0; i < 4; i++) {
+        key = splitMix(key);
+        rng->s[i] = key;
+    }
+    //xoshiro must not start from all zeros
+    if ((rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3]) == 0) {
+        rng->s[0] = 1;
+    }
+}
+
+/*
+    Makes a stream the one randInt and randFloat draw from on the calling thread.
+        in:   rng - the stream, or NULL to go back to the thread's own fallback stream
+*/
+void rngUse(Rng* rng) {
+    currentRng = rng;
+}
+
+/*
+    Returns the next raw value of a stream, using xoshiro256**.
+        in/out: rng - the stream
+    return:   a uniformly distributed 64-bit value
+*/
+uint64_t rngNext(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft(s[3], 45);
+    return result;
+}
+
+/*
+    Returns a uniformly distributed integer below n, with Lemire's multiply-shift method: one multiplication,
+    and a division only in the rare case the draw falls in the biased low end.
+        in/out: rng - the stream
+        in:   n - the size of the range, greater than 0
+    return:   a random integer in the range [0, n)
+*/
+uint32_t rngBelow(Rng* rng, uint32_t n) {
+    uint64_t m = (uint64_t) (uint32_t) (rngNext(rng) >> 32) * n;
+    uint32_t low = (uint32_t) m;
+    if (low < n) {
+        uint32_t threshold = -n % n;
+        while (low < threshold) {
+            m = (uint64_t) (uint32_t) (rngNext(rng) >> 32) * n;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+/*
+    Returns the stream randInt and randFloat draw from on the calling thread. Threads that are not running an
+    agent (benchmarks, helpers) get a fallback stream of their own, numbered in the order they first draw.
+*/
+Rng* threadRng() {
+    static __thread Rng fallback;
+    static __thread int seeded = C_FALSE;
+    if (currentRng != NULL) {
+        return currentRng;
     }
+    if (!seeded) {
+        unsigned int stream = __sync_fetch_and_add(&nextStream, 1);
+        rngInit(&fallback, -1, (int) stream);
+        seeded = C_TRUE;
+    }
+    return &fallback;
+}
+
+/*
+    Mixes a 64-bit value with the splitmix64 finalizer, used to expand seeds into generator state.
+*/
+uint64_t splitMix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
 
-    float random = ((float) rand_r(&seed)) / (float) RAND_MAX;
-    float diff = max - min;
-    float r = random * diff;
-    return min + r;
+/*
+    Rotates a 64-bit value left by k bits.
+*/
+uint64_t rotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
 /* 
@@ -43,23 +159,7 @@ enum GhostClass randomGhost() {
         out: str - the string representation of the given enum EvidenceType, minimum 16 characters
 */
 void evidenceToString(enum EvidenceType type, char* str) {
-    switch (type) {
-        case EMF:
-            strcpy(str, "EMF");
-            break;
-        case TEMPERATURE:
-            strcpy(str, "TEMPERATURE");
-            break;
-        case FINGERPRINTS:
-            strcpy(str, "FINGERPRINTS");
-            break;
-        case SOUND:
-            strcpy(str, "SOUND");
-            break;
-        default:
-            strcpy(str, "UNKNOWN");
-            break;
-    }
+    strcpy(str, ((unsigned int) type < EV_COUNT) ? evidenceNames[type] : "UNKNOWN");
 }
 
 /* 
@@ -68,22 +168,5 @@ void evidenceToString(enum EvidenceType type, char* str) {
         out: buffer - the string representation of the given enum GhostClass, minimum 16 characters
 */
 void ghostToString(enum GhostClass ghost, char* buffer) {
-    switch(ghost) {
-        case BANSHEE:
-            strcpy(buffer, "Banshee");
-            break;
-        case BULLIES:
-            strcpy(buffer, "Bullies");
-            break;
-        case PHANTOM:
-            strcpy(buffer, "Phantom");
-            break;
-        case POLTERGEIST:
-            strcpy(buffer, "Poltergeist");
-            break;
-        default:
-            strcpy(buffer, "Unknown");
-            break;
-        
-    }
+    strcpy(buffer, ((unsigned int) ghost < GHOST_COUNT) ? ghostNames[ghost] : "Unknown");
 }
@@ -0,0 +1,233 @@
+#include "defs.h"
+
+//Forward declarations
+int startLive(Worker* worker, LiveGame* game, char hunterNames[][MAX_STR], unsigned int* victimSeed, TimerWheel* wheel);
+void finishLive(Worker* worker, LiveGame* game);
+void scheduleLive(TimerWheel* wheel, LiveGame* game);
+long wheelNow(TimerWheel* wheel);
+long liveDue(TimerWheel* wheel, LiveGame* game);
+int armWheel(TimerWheel* wheel);
+void recordLateness(BatchStats* stats, long late);
+
+/*
+    Function: runWheel(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed)
+    Purpose:  Plays run ids from the farm in real time, up to options->live games at once on the worker's thread. Each game is
+              played a hunters' turn at a time with playSchedule, and waits for its next one in a timer wheel. The thread
+              sleeps in epoll on a timerfd armed for the next slot with a game in it, so however many games it paces it
+              wakes once per slot that is due rather than once per agent. How late each turn starts is added to the stats.
+    Params:
+        Input/Output: Worker* worker - points to the worker, its stats get the result of every game.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters.
+        Input/Output: unsigned int* victimSeed - stores the state findTask uses to pick a victim.
+    Return: void
+*/
+void runWheel(Worker* worker, char hunterNames[][MAX_STR], unsigned int* victimSeed){
+    int capacity = worker->options->live;
+    LiveGame* games = (LiveGame*) calloc(capacity, sizeof(LiveGame));
+    TimerWheel wheel;
+    memset(&wheel, 0, sizeof(TimerWheel));
+    clock_gettime(CLOCK_MONOTONIC, &(wheel.origin));
+    wheel.timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wheel.poll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = wheel.timer;
+    epoll_ctl(wheel.poll, EPOLL_CTL_ADD, wheel.timer, &event);
+    int playing = 0;
+    for(int i = 0; i < capacity; i++){
+        games[i].arena.chunkBytes = WHEEL_ARENA_BYTES;
+        if(startLive(worker, &(games[i]), hunterNames, victimSeed, &wheel) == C_FALSE){
+            break;
+        }
+        playing++;
+    }
+    while(playing > 0){
+        if(armWheel(&wheel) == C_TRUE && epoll_wait(wheel.poll, &event, 1, -1) == 1){
+            //Reading the timerfd clears its expirations, an interrupted wait just fires whatever is due
+            uint64_t expirations;
+            if(read(wheel.timer, &expirations, sizeof(expirations)) < 0){
+                continue;
+            }
+        }
+        long target = wheelNow(&wheel) / WHEEL_TICK;
+        while(wheel.tick <= target){
+            LiveGame** link = &(wheel.slots[wheel.tick % WHEEL_SLOTS]);
+            LiveGame* due = NULL;
+            //Take the games due at this tick out of the slot, those due a turn of the wheel later stay
+            while(*link != NULL){
+                LiveGame* game = *link;
+                if(game->dueTick <= wheel.tick){
+                    *link = game->next;
+                    game->next = due;
+                    due = game;
+                }
+                else{
+                    link = &(game->next);
+                }
+            }
+            //Games put back in the wheel from here on land in a later tick, even when their turn is already overdue
+            wheel.tick++;
+            while(due != NULL){
+                LiveGame* game = due;
+                due = game->next;
+                recordLateness(&(worker->stats), wheelNow(&wheel) - liveDue(&wheel, game));
+                if(playSchedule(&(game->schedule), &(game->house), game->schedule.due) == C_TRUE){
+                    scheduleLive(&wheel, game);
+                    continue;
+                }
+                finishLive(worker, game);
+                //The slot is taken by the next run id straight away
+                if(startLive(worker, game, hunterNames, victimSeed, &wheel) == C_FALSE){
+                    playing--;
+                }
+            }
+        }
+    }
+    for(int i = 0; i < capacity; i++){
+        arenaFree(&(games[i].arena));
+    }
+    close(wheel.poll);
+    close(wheel.timer);
+    free(games);
+}
+
+/*
+    Function: startLive(Worker* worker, LiveGame* game, char hunterNames[][MAX_STR], unsigned int* victimSeed, TimerWheel* wheel)
+    Purpose:  Takes the next run id and starts its game now, playing the ghost turns before the first hunters' turn and putting
+              the game in the wheel for that turn.
+    Params:
+        Input/Output: Worker* worker - points to the worker.
+        Output: LiveGame* game - points to a game slot with no game in it.
+        Input: char hunterNames[][MAX_STR] - stores the names of the hunters.
+        Input/Output: unsigned int* victimSeed - stores the state findTask uses to pick a victim.
+        Input/Output: TimerWheel* wheel - points to the worker's timer wheel.
+    Return: int - returns C_TRUE if a game was started, or C_FALSE if there are no run ids left
+*/
+int startLive(Worker* worker, LiveGame* game, char hunterNames[][MAX_STR], unsigned int* victimSeed, TimerWheel* wheel){
+    int run;
+    while(findTask(worker, victimSeed, &run) == C_TRUE){
+        arenaUse(&(game->arena));
+        initGame(&(game->house), hunterNames, worker->options->hunters, worker->options->ghosts, run);
+        arenaUse(NULL);
+        initSchedule(&(game->schedule), &(game->house));
+        clock_gettime(CLOCK_MONOTONIC, &(game->house.startTime));
+        if(playSchedule(&(game->schedule), &(game->house), 0) == C_TRUE){
+            scheduleLive(wheel, game);
+            return C_TRUE;
+        }
+        //Only the hunters can decide a game, so this is never reached before their first turn
+        finishLive(worker, game);
+    }
+    return C_FALSE;
+}
+
+/*
+    Function: finishLive(Worker* worker, LiveGame* game)
+    Purpose:  Tallies a game that is over, as runGame does, and frees it into its arena.
+    Params:
+        Input/Output: Worker* worker - points to the worker, its stats get the result.
+        Input/Output: LiveGame* game - points to the game.
+    Return: void
+*/
+void finishLive(Worker* worker, LiveGame* game){
+    GameResult result;
+    traceEndGame(&(game->house));
+    evaluateGame(&(game->house), &result);
+    result.length = game->schedule.now;
+    recordResult(&(worker->stats), &result);
+    freeProgram(&(game->house));
+}
+
+/*
+    Function: scheduleLive(TimerWheel* wheel, LiveGame* game)
+    Purpose:  Puts a game in the wheel slot of its next hunters' turn, the first tick that is not before the turn is due.
+              A turn that is already overdue goes in the next tick to be fired.
+    Params:
+        Input/Output: TimerWheel* wheel - points to the worker's timer wheel.
+        Input/Output: LiveGame* game - points to the game, playSchedule left its next turn in schedule.due.
+    Return: void
+*/
+void scheduleLive(TimerWheel* wheel, LiveGame* game){
+    long tick = (liveDue(wheel, game) + WHEEL_TICK - 1) / WHEEL_TICK;
+    if(tick < wheel->tick){
+        tick = wheel->tick;
+    }
+    game->dueTick = tick;
+    game->next = wheel->slots[tick % WHEEL_SLOTS];
+    wheel->slots[tick % WHEEL_SLOTS] = game;
+}
+
+/*
+    Function: wheelNow(TimerWheel* wheel)
+    Purpose:  Reads the wall clock relative to the wheel's tick 0.
+    Params:
+        Input: TimerWheel* wheel - points to the timer wheel.
+    Return: long - returns the microseconds since tick 0.
+*/
+long wheelNow(TimerWheel* wheel){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - wheel->origin.tv_sec) * 1000000L + (now.tv_nsec - wheel->origin.tv_nsec) / 1000;
+}
+
+/*
+    Function: liveDue(TimerWheel* wheel, LiveGame* game)
+    Purpose:  Finds when a game's next hunters' turn is due on the wall clock.
+    Params:
+        Input: TimerWheel* wheel - points to the timer wheel.
+        Input: LiveGame* game - points to the game, playSchedule left its next turn in schedule.due.
+    Return: long - returns the microseconds from the wheel's tick 0 to the turn.
+*/
+long liveDue(TimerWheel* wheel, LiveGame* game){
+    struct timespec* start = &(game->house.startTime);
+    return (start->tv_sec - wheel->origin.tv_sec) * 1000000L + (start->tv_nsec - wheel->origin.tv_nsec) / 1000 + game->schedule.due;
+}
+
+/*
+    Function: armWheel(TimerWheel* wheel)
+    Purpose:  Arms the wheel's timerfd for the first slot from the next tick on with a game in it. A slot whose games are all
+              due a turn of the wheel later still wakes the thread, which then arms the timer again.
+    Params:
+        Input/Output: TimerWheel* wheel - points to the timer wheel.
+    Return: int - returns C_TRUE if the timer was armed and is worth waiting for, or C_FALSE if that slot is already due
+*/
+int armWheel(TimerWheel* wheel){
+    long tick = wheel->tick;
+    while(wheel->slots[tick % WHEEL_SLOTS] == NULL && tick < wheel->tick + WHEEL_SLOTS){
+        tick++;
+    }
+    long at = tick * WHEEL_TICK;
+    if(at <= wheelNow(wheel)){
+        return C_FALSE;
+    }
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value = wheel->origin;
+    addMicros(&(timer.it_value), at);
+    timerfd_settime(wheel->timer, TFD_TIMER_ABSTIME, &timer, NULL);
+    return C_TRUE;
+}
+
+/*
+    Function: recordLateness(BatchStats* stats, long late)
+    Purpose:  Adds how late a paced hunters' turn started to the jitter statistics.
+    Params:
+        Input/Output: BatchStats* stats - points to the worker's stats.
+        Input: long late - stores how many microseconds after it was due the turn started.
+    Return: void
+*/
+void recordLateness(BatchStats* stats, long late){
+    if(late < 0){
+        late = 0;
+    }
+    int bucket = 0;
+    while(bucket < JITTER_BUCKETS - 1 && (1L << bucket) <= late){
+        bucket++;
+    }
+    stats->lateHist[bucket]++;
+    stats->lateTotal += late;
+    if(late > stats->lateMax){
+        stats->lateMax = late;
+    }
+    stats->pacedTurns++;
+}